@@ -38,6 +38,8 @@ CONFIG += c++11
 SOURCES += \
     main.cpp \
     desktopicon.cpp \
+    filefilter.cpp \
+    filemeta.cpp \
     filesystemmodel.cpp \
     filestream.cpp \
     folderdelegate.cpp \
@@ -45,12 +47,20 @@ SOURCES += \
     folderview.cpp \
     iconcache.cpp \
     iconindex.cpp \
+    iconscheduler.cpp \
+    iconstore.cpp \
     iconsettings.cpp \
+    imagescaler.cpp \
     indexcache.cpp \
+    launcher.cpp \
+    launcherindex.cpp \
     listview.cpp \
     mapperwidget.cpp \
+    mimecache.cpp \
+    modelregistry.cpp \
     proxymodel.cpp \
     screenmapper.cpp \
+    searchindex.cpp \
     settings.cpp \
     themeeditor.cpp \
     themes.cpp \
@@ -72,6 +82,7 @@ FORMS += \
     about.ui \
     folderview.ui \
     iconsettings.ui \
+    launcher.ui \
     screenmapper.ui \
     settings.ui \
     themeeditor.ui \
@@ -82,6 +93,8 @@ HEADERS += \
     application.h \
     backgroundframe.h \
     desktopicon.h \
+    filefilter.h \
+    filemeta.h \
     filesystemmodel.h \
     filestream.h \
     folderdelegate.h \
@@ -89,13 +102,21 @@ HEADERS += \
     folderview.h \
     iconcache.h \
     iconindex.h \
+    iconscheduler.h \
+    iconstore.h \
     iconsettings.h \
+    imagescaler.h \
     indexcache.h \
+    launcher.h \
+    launcherindex.h \
     listview.h \
     main.h \
     mapperwidget.h \
+    mimecache.h \
+    modelregistry.h \
     proxymodel.h \
     screenmapper.h \
+    searchindex.h \
     settings.h \
     themeeditor.h \
     themes.h \
@@ -111,4 +132,6 @@ win32:HEADERS +=
 win32:RC_FILE = icon.rc
 win32:QT += winextras
 win32:LIBS += -lgdi32 -luser32 -luuid -lole32
+linux:SOURCES += directorymodel.cpp filewatcher.cpp
+linux:HEADERS += directorymodel.h filewatcher.h
 
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QtTest>
+#include <QtConcurrent>
+#include <QApplication>
+#include <QPixmap>
+#include <QPainter>
+#include <QTemporaryDir>
+#include "filemeta.h"
+#include "iconcache.h"
+#include "indexcache.h"
+#include "mimecache.h"
+
+/**
+ * @brief The IconPipelineTestNamespace namespace
+ */
+namespace IconPipelineTestNamespace {
+static const int FileCount = 64;
+static const int Rounds = 20;
+static const int BatchInterval = 16;
+static const int Timeout = 120000;
+}
+
+/**
+ * @brief The IconPipelineTest class stress test of the threaded icon pipeline under the offscreen
+ * platform: worker threads request thumbnails while the GUI thread converts the results to pixmaps
+ * in batches (like ProxyModel::processBatch) and asks for the same files through imageForFilename
+ *
+ * NOTE: run with QT_QPA_PLATFORM=offscreen (set by main() if unset), caches go to a temporary HOME
+ */
+class IconPipelineTest : public QObject {
+    Q_OBJECT
+
+public:
+    IconPipelineTest() : expected( 0 ), delivered( 0 ), nullImages( 0 ), converted( 0 ), announced( 0 ) {}
+
+private slots:
+    void initTestCase();
+    void stress();
+    void cleanupTestCase();
+    void processBatch();
+    void imageReady( const QString &fileName, int scale, const QImage &image );
+
+private:
+    struct Result {
+        bool cancelled;
+        int scale;
+        QImage image;
+    };
+    QString fileName( int index ) const { return this->dir.filePath( QString( "image_%1.png" ).arg( index )); }
+    QTemporaryDir dir;
+    QMutex mutex;
+    QList<Result> results;
+    QAtomicInt expected;
+    QAtomicInt delivered;
+    int nullImages;
+    int converted;
+    int announced;
+};
+
+/**
+ * @brief IconPipelineTest::initTestCase writes images of various shapes (smaller and larger than
+ * the requested scales, portrait and landscape)
+ */
+void IconPipelineTest::initTestCase() {
+    int y;
+
+    QVERIFY( this->dir.isValid());
+
+    for ( y = 0; y < IconPipelineTestNamespace::FileCount; y++ ) {
+        QImage image( 8 + ( y * 37 ) % 600, 8 + ( y * 53 ) % 400, QImage::Format_ARGB32 );
+        image.fill( QColor::fromHsv(( y * 29 ) % 360, 200, 220, 128 + y ));
+        {
+            QPainter painter( &image );
+            painter.drawEllipse( image.rect().adjusted( 2, 2, -2, -2 ));
+        }
+        QVERIFY( image.save( this->fileName( y )));
+    }
+
+    this->connect( IconCache::instance(), SIGNAL( imageReady( QString, int, QImage )), this, SLOT( imageReady( QString, int, QImage )));
+}
+
+/**
+ * @brief IconPipelineTest::stress every file at three scales for a number of rounds from the
+ * global thread pool, every fifth request is cancelled before (or while) it runs
+ */
+void IconPipelineTest::stress() {
+    QList<int> scales;
+    QTimer timer;
+    int y, round;
+
+    scales << 16 << 48 << 96;
+
+    timer.setInterval( IconPipelineTestNamespace::BatchInterval );
+    this->connect( &timer, SIGNAL( timeout()), this, SLOT( processBatch()));
+    timer.start();
+
+    for ( round = 0; round < IconPipelineTestNamespace::Rounds; round++ ) {
+        for ( y = 0; y < IconPipelineTestNamespace::FileCount; y++ ) {
+            foreach ( int scale, scales ) {
+                const FileMeta meta( FileMeta::fromFileInfo( QFileInfo( this->fileName( y ))));
+                const bool cancelled = (( round * IconPipelineTestNamespace::FileCount + y + scale ) % 5 ) == 0;
+
+                this->expected.ref();
+                QtConcurrent::run( [ this, meta, scale, cancelled ]() {
+                    IconCache::instance()->requestImageForFilename( meta, scale, false, [ cancelled ]() { return cancelled; }, [ this, scale, cancelled ]( const QImage &image ) {
+                        QMutexLocker lock( &this->mutex );
+                        Result result;
+
+                        result.cancelled = cancelled;
+                        result.scale = scale;
+                        result.image = image;
+                        this->results << result;
+                        this->delivered.ref();
+                    } );
+                } );
+            }
+
+            // the GUI thread competes for the same files
+            if ( !( y % 8 ))
+                IconCache::instance()->imageForFilename( this->fileName( y ), scales.at( round % scales.count()));
+        }
+
+        QCoreApplication::processEvents();
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT( this->delivered.load(), this->expected.load(), IconPipelineTestNamespace::Timeout );
+    QVERIFY( QThreadPool::globalInstance()->waitForDone( IconPipelineTestNamespace::Timeout ));
+    this->processBatch();
+    timer.stop();
+
+    qInfo() << "requests" << this->expected.load() << "converted" << this->converted << "announced" << this->announced;
+    qInfo() << "requested" << IconCache::instance()->requestCount() << "coalesced" << IconCache::instance()->coalescedCount();
+
+    QCOMPARE( this->converted, this->expected.load());
+    QCOMPARE( this->nullImages, 0 );
+}
+
+/**
+ * @brief IconPipelineTest::processBatch converts delivered images to pixmaps on the GUI thread
+ */
+void IconPipelineTest::processBatch() {
+    QList<Result> batch;
+
+    {
+        QMutexLocker lock( &this->mutex );
+        batch.swap( this->results );
+    }
+
+    foreach ( const Result &result, batch ) {
+        const QPixmap pixmap( QPixmap::fromImage( result.image ));
+
+        // cancelled requests may be abandoned, all others must produce a thumbnail
+        if ( !result.cancelled && ( pixmap.isNull() || pixmap.width() != result.scale || pixmap.height() != result.scale ))
+            this->nullImages++;
+
+        this->converted++;
+    }
+}
+
+/**
+ * @brief IconPipelineTest::imageReady late results of the GUI thread's own requests
+ * @param fileName
+ * @param scale
+ * @param image
+ */
+void IconPipelineTest::imageReady( const QString &fileName, int scale, const QImage &image ) {
+    Q_UNUSED( fileName )
+
+    if ( QPixmap::fromImage( image ).isNull() || image.width() != scale )
+        this->nullImages++;
+
+    this->announced++;
+}
+
+/**
+ * @brief IconPipelineTest::cleanupTestCase
+ */
+void IconPipelineTest::cleanupTestCase() {
+    IconCache::instance()->shutdown();
+    MimeCache::instance()->shutdown();
+    IndexCache::instance()->shutdown();
+}
+
+/**
+ * @brief main
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main( int argc, char *argv[] ) {
+    QTemporaryDir home;
+
+    // no display needed, keep caches out of the real home directory
+    if ( qEnvironmentVariableIsEmpty( "QT_QPA_PLATFORM" ))
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+
+    qputenv( "HOME", home.path().toLocal8Bit());
+    qputenv( "USERPROFILE", home.path().toLocal8Bit());
+
+    QApplication app( argc, argv );
+    IconPipelineTest test;
+    return QTest::qExec( &test, argc, argv );
+}
+
+#include "tst_iconpipeline.moc"
@@ -0,0 +1,33 @@
+#
+# Copyright (C) 2018 Zvaigznu Planetarijs
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see http://www.gnu.org/licenses/.
+#
+
+QT       += core gui testlib
+QT       -= widgets
+
+TARGET = tst_imagescaler
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../imagescaler.cpp \
+    tst_imagescaler.cpp
+
+HEADERS += \
+    ../../imagescaler.h
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QtTest>
+#include <QImage>
+#include <cmath>
+#include "imagescaler.h"
+
+/**
+ * @brief The ImageScalerBenchmark class quality (PSNR against an exact area average) and speed
+ * of ImageScaler compared to the nearest-then-smooth downscale it replaced
+ */
+class ImageScalerBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void exactness_data();
+    void exactness();
+    void quality_data();
+    void quality();
+    void speed_data();
+    void speed();
+
+private:
+    static QImage legacyDownscale( const QImage &image, int scale );
+    static QImage boxReference( const QImage &image, int xFactor, int yFactor );
+    static QImage areaReference( const QImage &image, int width, int height );
+    static double psnr( const QImage &image, const QImage &reference );
+    QImage source;
+};
+
+/**
+ * @brief ImageScalerBenchmark::initTestCase builds a detailed source image (fine stripes alias
+ * badly with nearest sampling, noise and alpha cover the rest of the kernel)
+ */
+void ImageScalerBenchmark::initTestCase() {
+    int x, y;
+    quint32 seed = 1;
+
+    this->source = QImage( 1536, 1536, QImage::Format_ARGB32 );
+    for ( y = 0; y < this->source.height(); y++ ) {
+        QRgb *line = reinterpret_cast<QRgb*>( this->source.scanLine( y ));
+
+        for ( x = 0; x < this->source.width(); x++ ) {
+            seed = seed * 1103515245u + 12345u;
+
+            line[x] = qRgba((( x / 3 ) % 2 ) ? 255 : 0,
+                            ( x * 255 ) / this->source.width(),
+                            ( seed >> 16 ) & 0xff,
+                            128 + (( y * 127 ) / this->source.height()));
+        }
+    }
+
+    this->source = this->source.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+    qInfo() << "kernel" << ImageScaler::kernel();
+}
+
+/**
+ * @brief ImageScalerBenchmark::legacyDownscale former IconCache::fastDownscale (on QImage, so that
+ * it can run without a GUI)
+ * @param image
+ * @param scale
+ * @return
+ */
+QImage ImageScalerBenchmark::legacyDownscale( const QImage &image, int scale ) {
+    QImage downScaled( image );
+
+    if ( downScaled.width() >= scale * 2 )
+        downScaled = downScaled.scaled( scale * 2, scale * 2, Qt::IgnoreAspectRatio, Qt::FastTransformation );
+
+    return downScaled.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+}
+
+/**
+ * @brief ImageScalerBenchmark::boxReference scalar box average (same rounding as ImageScaler)
+ * @param image
+ * @param xFactor
+ * @param yFactor
+ * @return
+ */
+QImage ImageScalerBenchmark::boxReference( const QImage &image, int xFactor, int yFactor ) {
+    const int width = image.width() / xFactor;
+    const int height = image.height() / yFactor;
+    const quint32 area = static_cast<quint32>( xFactor * yFactor );
+    QImage result( width, height, QImage::Format_ARGB32_Premultiplied );
+    int x, y, c, i, k;
+
+    for ( y = 0; y < height; y++ ) {
+        uchar *line = result.scanLine( y );
+
+        for ( x = 0; x < width; x++ ) {
+            for ( c = 0; c < 4; c++ ) {
+                quint32 sum = 0;
+
+                for ( k = 0; k < yFactor; k++ ) {
+                    const uchar *pixel = image.constScanLine( y * yFactor + k ) + x * xFactor * 4 + c;
+
+                    for ( i = 0; i < xFactor; i++ )
+                        sum += pixel[i * 4];
+                }
+
+                line[x * 4 + c] = static_cast<uchar>(( sum + area / 2 ) / area );
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief ImageScalerBenchmark::areaReference exact area average for any ratio (each source pixel
+ * is weighted by how much of it an output pixel covers)
+ * @param image
+ * @param width
+ * @param height
+ * @return
+ */
+QImage ImageScalerBenchmark::areaReference( const QImage &image, int width, int height ) {
+    const double xRatio = static_cast<double>( image.width()) / width;
+    const double yRatio = static_cast<double>( image.height()) / height;
+    QImage result( width, height, QImage::Format_ARGB32_Premultiplied );
+    int x, y, sx, sy, c;
+
+    for ( y = 0; y < height; y++ ) {
+        const double top = y * yRatio, bottom = ( y + 1 ) * yRatio;
+        uchar *line = result.scanLine( y );
+
+        for ( x = 0; x < width; x++ ) {
+            const double left = x * xRatio, right = ( x + 1 ) * xRatio;
+            double sum[4] = { 0, 0, 0, 0 };
+
+            for ( sy = static_cast<int>( top ); sy < bottom && sy < image.height(); sy++ ) {
+                const double h = qMin<double>( sy + 1, bottom ) - qMax<double>( sy, top );
+                const uchar *source = image.constScanLine( sy );
+
+                for ( sx = static_cast<int>( left ); sx < right && sx < image.width(); sx++ ) {
+                    const double weight = h * ( qMin<double>( sx + 1, right ) - qMax<double>( sx, left ));
+
+                    for ( c = 0; c < 4; c++ )
+                        sum[c] += source[sx * 4 + c] * weight;
+                }
+            }
+
+            for ( c = 0; c < 4; c++ )
+                line[x * 4 + c] = static_cast<uchar>( qBound( 0.0, sum[c] / ( xRatio * yRatio ) + 0.5, 255.0 ));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief ImageScalerBenchmark::psnr peak signal-to-noise ratio over all channels
+ * @param image
+ * @param reference
+ * @return
+ */
+double ImageScalerBenchmark::psnr( const QImage &image, const QImage &reference ) {
+    const QImage converted( image.convertToFormat( QImage::Format_ARGB32_Premultiplied ));
+    double error = 0.0;
+    int x, y;
+
+    for ( y = 0; y < reference.height(); y++ ) {
+        const uchar *a = converted.constScanLine( y );
+        const uchar *b = reference.constScanLine( y );
+
+        for ( x = 0; x < reference.width() * 4; x++ )
+            error += ( a[x] - b[x] ) * ( a[x] - b[x] );
+    }
+
+    error /= reference.width() * reference.height() * 4.0;
+    if ( error == 0.0 )
+        return INFINITY;
+
+    return 10.0 * std::log10( 255.0 * 255.0 / error );
+}
+
+/**
+ * @brief ImageScalerBenchmark::exactness_data
+ */
+void ImageScalerBenchmark::exactness_data() {
+    QTest::addColumn<int>( "xFactor" );
+    QTest::addColumn<int>( "yFactor" );
+
+    QTest::newRow( "2x2" ) << 2 << 2;
+    QTest::newRow( "3x3" ) << 3 << 3;
+    QTest::newRow( "7x5" ) << 7 << 5;
+    QTest::newRow( "8x8" ) << 8 << 8;
+    QTest::newRow( "16x16" ) << 16 << 16;
+    QTest::newRow( "33x33" ) << 33 << 33;
+}
+
+/**
+ * @brief ImageScalerBenchmark::exactness the runtime selected kernel must match the scalar reference
+ */
+void ImageScalerBenchmark::exactness() {
+    QFETCH( int, xFactor );
+    QFETCH( int, yFactor );
+
+    QCOMPARE( ImageScaler::boxDownscale( this->source, xFactor, yFactor ), ImageScalerBenchmark::boxReference( this->source, xFactor, yFactor ));
+}
+
+/**
+ * @brief ImageScalerBenchmark::quality_data
+ */
+void ImageScalerBenchmark::quality_data() {
+    QTest::addColumn<int>( "scale" );
+
+    QTest::newRow( "256 (integer ratio)" ) << 256;
+    QTest::newRow( "96 (integer ratio)" ) << 96;
+    QTest::newRow( "100" ) << 100;
+    QTest::newRow( "48" ) << 48;
+}
+
+/**
+ * @brief ImageScalerBenchmark::quality reports PSNR of both downscalers against an exact area average
+ */
+void ImageScalerBenchmark::quality() {
+    QFETCH( int, scale );
+
+    const QImage reference( ImageScalerBenchmark::areaReference( this->source, scale, scale ));
+    const double area = ImageScalerBenchmark::psnr( ImageScaler::downscale( this->source, scale ), reference );
+    const double legacy = ImageScalerBenchmark::psnr( ImageScalerBenchmark::legacyDownscale( this->source, scale ), reference );
+
+    qInfo( "%d px: area %.2f dB, legacy %.2f dB", scale, area, legacy );
+}
+
+/**
+ * @brief ImageScalerBenchmark::speed_data
+ */
+void ImageScalerBenchmark::speed_data() {
+    QTest::addColumn<int>( "scale" );
+    QTest::addColumn<bool>( "legacy" );
+
+    QTest::newRow( "area 256" ) << 256 << false;
+    QTest::newRow( "legacy 256" ) << 256 << true;
+    QTest::newRow( "area 100" ) << 100 << false;
+    QTest::newRow( "legacy 100" ) << 100 << true;
+    QTest::newRow( "area 48" ) << 48 << false;
+    QTest::newRow( "legacy 48" ) << 48 << true;
+}
+
+/**
+ * @brief ImageScalerBenchmark::speed
+ */
+void ImageScalerBenchmark::speed() {
+    QFETCH( int, scale );
+    QFETCH( bool, legacy );
+    QImage result;
+
+    if ( legacy ) {
+        QBENCHMARK { result = ImageScalerBenchmark::legacyDownscale( this->source, scale ); }
+    } else {
+        QBENCHMARK { result = ImageScaler::downscale( this->source, scale ); }
+    }
+
+    QCOMPARE( result.size(), QSize( scale, scale ));
+}
+
+QTEST_GUILESS_MAIN( ImageScalerBenchmark )
+#include "tst_imagescaler.moc"
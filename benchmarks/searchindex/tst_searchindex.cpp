@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QtTest>
+#include "searchindex.h"
+
+/**
+ * @brief The SearchIndexBenchmarkNamespace namespace
+ */
+namespace SearchIndexBenchmarkNamespace {
+static const int EntryCount = 50000;
+}
+
+/**
+ * @brief The SearchIndexBenchmark class type-to-filter work per keystroke over 50k names
+ *
+ * NOTE: covers the index side of a keystroke (query and the per row lookup done by
+ *       ProxyModel::filterAcceptsRow), not the view's relayout and repaint
+ */
+class SearchIndexBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void build();
+    void query_data();
+    void query();
+    void typing();
+    void filter();
+
+private:
+    int expected( const QString &text ) const;
+    QStringList names;
+    SearchIndex index;
+};
+
+/**
+ * @brief SearchIndexBenchmark::initTestCase generates names that look like a busy download folder
+ */
+void SearchIndexBenchmark::initTestCase() {
+    const QStringList words( QStringList() << "report" << "Invoice" << "photo" << "IMG" << "backup" << "draft" << "Übersicht" << "résumé" << "заметки" << "写真" << "final" << "copy" );
+    const QStringList extensions( QStringList() << "pdf" << "jpg" << "png" << "txt" << "tar.gz" << "docx" );
+    quint32 seed = 1;
+    int y;
+
+    for ( y = 0; y < SearchIndexBenchmarkNamespace::EntryCount; y++ ) {
+        seed = seed * 1103515245u + 12345u;
+
+        this->names << QString( "%1_%2 %3 (%4).%5" )
+                       .arg( words.at(( seed >> 8 ) % words.count()))
+                       .arg( words.at(( seed >> 16 ) % words.count()))
+                       .arg( y )
+                       .arg(( seed >> 4 ) % 100 )
+                       .arg( extensions.at(( seed >> 24 ) % extensions.count()));
+    }
+
+    for ( y = 0; y < this->names.count(); y++ )
+        this->index.insert( static_cast<quintptr>( y + 1 ), this->names.at( y ));
+}
+
+/**
+ * @brief SearchIndexBenchmark::expected brute force match count
+ * @param text
+ * @return
+ */
+int SearchIndexBenchmark::expected( const QString &text ) const {
+    const QString folded( text.toCaseFolded());
+    int count = 0;
+
+    foreach ( const QString &name, this->names ) {
+        if ( name.toCaseFolded().contains( folded ))
+            count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief SearchIndexBenchmark::build indexing all names (first keystroke of a search)
+ */
+void SearchIndexBenchmark::build() {
+    QBENCHMARK {
+        SearchIndex index;
+        int y;
+
+        for ( y = 0; y < this->names.count(); y++ )
+            index.insert( static_cast<quintptr>( y + 1 ), this->names.at( y ));
+    }
+}
+
+/**
+ * @brief SearchIndexBenchmark::query_data
+ */
+void SearchIndexBenchmark::query_data() {
+    QTest::addColumn<QString>( "text" );
+
+    QTest::newRow( "short" ) << "re";
+    QTest::newRow( "common" ) << "report";
+    QTest::newRow( "number" ) << "4711";
+    QTest::newRow( "unicode" ) << "übers";
+    QTest::newRow( "cyrillic" ) << "ЗАМЕТ";
+    QTest::newRow( "missing" ) << "xyzzy";
+}
+
+/**
+ * @brief SearchIndexBenchmark::query a query unrelated to the previous one (no narrowing)
+ */
+void SearchIndexBenchmark::query() {
+    QFETCH( QString, text );
+
+    QBENCHMARK {
+        this->index.setQuery( QString());
+        this->index.setQuery( text );
+    }
+
+    QCOMPARE( this->index.matchCount(), this->expected( text ));
+}
+
+/**
+ * @brief SearchIndexBenchmark::typing a word typed one character at a time
+ */
+void SearchIndexBenchmark::typing() {
+    const QString word( "invoice_photo" );
+    int y;
+
+    QBENCHMARK {
+        this->index.setQuery( QString());
+        for ( y = 1; y <= word.length(); y++ )
+            this->index.setQuery( word.left( y ));
+    }
+
+    QCOMPARE( this->index.matchCount(), this->expected( word ));
+}
+
+/**
+ * @brief SearchIndexBenchmark::filter per row lookups of a filter pass over all entries
+ */
+void SearchIndexBenchmark::filter() {
+    int y, count = 0;
+
+    this->index.setQuery( "photo" );
+    QBENCHMARK {
+        count = 0;
+        for ( y = 0; y < this->names.count(); y++ ) {
+            if ( this->index.matches( static_cast<quintptr>( y + 1 )))
+                count++;
+        }
+    }
+
+    QCOMPARE( count, this->expected( "photo" ));
+}
+
+QTEST_APPLESS_MAIN( SearchIndexBenchmark )
+#include "tst_searchindex.moc"
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QtTest>
+#include <algorithm>
+#include <numeric>
+#include "proxymodel.h"
+
+/**
+ * @brief The SortKeysBenchmarkNamespace namespace
+ */
+namespace SortKeysBenchmarkNamespace {
+static const int EntryCount = 100000;
+}
+
+/**
+ * @brief The SortKeysBenchmark class sorts 100k synthetic entries the way ProxyModel::lessThan
+ * does (directories first, ascending), with per comparison lowercasing (as lessThan did before
+ * sort keys) and with precomputed ProxySortKey keys
+ *
+ * NOTE: the old lessThan also built two QFileInfo objects per comparison, that part is not
+ *       included here, so the legacy numbers are a lower bound
+ */
+class SortKeysBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void legacy();
+    void keys_data();
+    void keys();
+    void numericOrder();
+
+private:
+    QStringList names;
+    QVector<bool> dirs;
+};
+
+/**
+ * @brief SortKeysBenchmark::initTestCase generates numbered, mixed case and non-latin names
+ */
+void SortKeysBenchmark::initTestCase() {
+    const QStringList words( QStringList() << "Photo" << "report" << "IMG_" << "Übersicht" << "résumé" << "заметки" << "写真" << "backup" << "Draft" );
+    int y;
+
+    for ( y = 0; y < SortKeysBenchmarkNamespace::EntryCount; y++ ) {
+        this->names << QString( "%1 %2.%3" ).arg( words.at(( y * 7 ) % words.count())).arg(( y * 7919 ) % 5000 ).arg( y % 7 ? "jpg" : "txt" );
+        this->dirs << !( y % 10 );
+    }
+}
+
+/**
+ * @brief SortKeysBenchmark::legacy lowercases both names on every comparison
+ */
+void SortKeysBenchmark::legacy() {
+    QVector<int> order( this->names.count());
+
+    QBENCHMARK {
+        std::iota( order.begin(), order.end(), 0 );
+        std::sort( order.begin(), order.end(), [ this ]( int left, int right ) {
+            if ( this->dirs.at( left ) != this->dirs.at( right ))
+                return this->dirs.at( left );
+
+            return this->names.at( left ).toLower() < this->names.at( right ).toLower();
+        } );
+    }
+}
+
+/**
+ * @brief SortKeysBenchmark::keys_data
+ */
+void SortKeysBenchmark::keys_data() {
+    QTest::addColumn<bool>( "numeric" );
+
+    QTest::newRow( "casefolded" ) << false;
+    QTest::newRow( "collator numeric" ) << true;
+}
+
+/**
+ * @brief SortKeysBenchmark::keys builds one key per entry (as ProxyModel::sortKey does on first
+ * use), then sorts on the keys
+ */
+void SortKeysBenchmark::keys() {
+    QFETCH( bool, numeric );
+    QVector<ProxySortKey> sortKeys( this->names.count());
+    QVector<int> order( this->names.count());
+    QCollator collator;
+    int y;
+
+    collator.setCaseSensitivity( Qt::CaseInsensitive );
+    collator.setNumericMode( numeric );
+
+    QBENCHMARK {
+        for ( y = 0; y < this->names.count(); y++ )
+            sortKeys[y] = ProxySortKey::fromName( this->names.at( y ), this->dirs.at( y ), false, numeric ? &collator : nullptr );
+
+        std::iota( order.begin(), order.end(), 0 );
+        std::sort( order.begin(), order.end(), [ &sortKeys ]( int left, int right ) {
+            if ( sortKeys.at( left ).dir != sortKeys.at( right ).dir )
+                return sortKeys.at( left ).dir;
+
+            return sortKeys.at( left ).compare( sortKeys.at( right )) < 0;
+        } );
+    }
+
+    // directories first
+    QVERIFY( this->dirs.at( order.first()));
+    QVERIFY( !this->dirs.at( order.last()));
+}
+
+/**
+ * @brief SortKeysBenchmark::numericOrder natural order puts "file 2" before "file 10"
+ */
+void SortKeysBenchmark::numericOrder() {
+    QCollator collator;
+
+    collator.setCaseSensitivity( Qt::CaseInsensitive );
+    collator.setNumericMode( true );
+
+    QVERIFY( ProxySortKey::fromName( "file 2", false, false, &collator ).compare( ProxySortKey::fromName( "File 10", false, false, &collator )) < 0 );
+    QVERIFY( ProxySortKey::fromName( "file 2", false, false ).compare( ProxySortKey::fromName( "File 10", false, false )) > 0 );
+}
+
+QTEST_GUILESS_MAIN( SortKeysBenchmark )
+
+#include "tst_sortkeys.moc"
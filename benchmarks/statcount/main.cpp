@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QCoreApplication>
+#include <QDirIterator>
+#include <QDebug>
+#include <QElapsedTimer>
+#include "filemeta.h"
+#include "mimecache.h"
+
+/**
+ * @brief legacy metadata lookups done per icon before FileMeta (ProxyModel::data passed a plain
+ * path, IconCache::imageForFilename and MimeCache::mimeType looked everything up again)
+ * @param fileName
+ * @return
+ */
+static int legacy( const QString &fileName ) {
+    const QFileInfo info( fileName );
+    const QFileInfo target( info.symLinkTarget());
+    const QString absolutePath( info.isSymLink() ? target.absoluteFilePath() : info.absoluteFilePath());
+    const bool isDir = info.isDir() || target.isDir();
+    const bool isRoot = info.isRoot() || target.isRoot();
+
+    // mimetype revision key
+    const MimeEntry entry( MimeCache::statFile( absolutePath ));
+
+    return isDir + isRoot + entry.key.isValid();
+}
+
+/**
+ * @brief meta metadata lookups done per icon now (the model's cached file info is reused,
+ * the file is stat-ed again only if the mimetype key cannot be built from it)
+ * @param info
+ * @return
+ */
+static int meta( const QFileInfo &info ) {
+    const FileMeta meta( FileMeta::fromFileInfo( info ));
+    MimeEntry entry( MimeKey( meta.device, meta.inode ), meta.modified / 1000 );
+
+    if ( !meta.inode || meta.isSymLink())
+        entry = MimeCache::statFile( meta.absolutePath());
+
+    return meta.isDir() + meta.isRoot() + entry.key.isValid();
+}
+
+/**
+ * @brief main lists a directory like the source model does (every entry stat-ed once), then runs
+ * the per icon metadata work of the selected mode on every entry
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main( int argc, char *argv[] ) {
+    QCoreApplication app( argc, argv );
+    QList<QFileInfo> entries;
+    QElapsedTimer timer;
+    QString mode;
+    int checksum = 0;
+
+    if ( app.arguments().count() != 3 ) {
+        qInfo() << "usage: statcount list|legacy|meta <dir>";
+        return 1;
+    }
+
+    mode = app.arguments().at( 1 );
+    if ( mode != "list" && mode != "legacy" && mode != "meta" ) {
+        qInfo() << "unknown mode" << mode;
+        return 1;
+    }
+
+    // listing (same in every mode, subtract the "list" run to get the per icon part)
+    QDirIterator it( app.arguments().at( 2 ), QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System );
+    while ( it.hasNext()) {
+        it.next();
+
+        QFileInfo info( it.fileInfo());
+        info.refresh();
+        info.size();
+        entries << info;
+    }
+
+    timer.start();
+    foreach ( const QFileInfo &info, entries ) {
+        if ( mode == "legacy" )
+            checksum += legacy( info.filePath());
+        else if ( mode == "meta" )
+            checksum += meta( info );
+    }
+
+    qInfo().noquote() << mode << entries.count() << "entries" << timer.nsecsElapsed() / 1000 << "us" << checksum;
+    return 0;
+}
@@ -0,0 +1,46 @@
+#
+# Copyright (C) 2018 Zvaigznu Planetarijs
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program. If not, see http://www.gnu.org/licenses/.
+#
+
+# syscall count of the per icon metadata work (old QFileInfo chain vs FileMeta), run under strace:
+#   strace -c -f ./statcount list <dir>
+#   strace -c -f ./statcount legacy <dir>
+#   strace -c -f ./statcount meta <dir>
+# (mode total - list total) / entry count gives the syscalls per icon
+QT       += core gui xml
+QT       -= widgets
+
+TARGET = statcount
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../filemeta.cpp \
+    ../../filestream.cpp \
+    ../../iconindex.cpp \
+    ../../indexcache.cpp \
+    ../../mimecache.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../filemeta.h \
+    ../../filestream.h \
+    ../../iconindex.h \
+    ../../indexcache.h \
+    ../../mimecache.h
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QtTest>
+#include <QApplication>
+#include "folderdelegate.h"
+
+/**
+ * @brief The TextLayoutBenchmarkNamespace namespace
+ */
+namespace TextLayoutBenchmarkNamespace {
+static const int Width = 96;
+static const int LayoutCount = 1000;
+}
+
+/**
+ * @brief The TextLayoutBenchmark class label layout of long (mostly non-latin) filenames: the old
+ * per character prefix measuring, FolderDelegate::layoutText and a layout cache hit
+ */
+class TextLayoutBenchmark : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void legacy_data() { this->names(); }
+    void legacy();
+    void layout_data() { this->names(); }
+    void layout();
+    void cached_data() { this->names(); }
+    void cached();
+
+private:
+    void names();
+    static int legacyLayout( const QString &text, const QFontMetrics &fontMetrics, int width, int lineCount );
+    QFont font;
+};
+
+/**
+ * @brief TextLayoutBenchmark::initTestCase
+ */
+void TextLayoutBenchmark::initTestCase() {
+    this->font = QApplication::font();
+}
+
+/**
+ * @brief TextLayoutBenchmark::names long filenames in various scripts (with and without spaces)
+ */
+void TextLayoutBenchmark::names() {
+    QTest::addColumn<QString>( "text" );
+
+    QTest::newRow( "short latin" ) << QString( "report.pdf" );
+    QTest::newRow( "long latin" ) << QString( "Quarterly financial report for the northern region final revised version 3 (copy).pdf" );
+    QTest::newRow( "long latin, no spaces" ) << QString( "quarterly_financial_report_for_the_northern_region_final_revised_version_3_copy.pdf" );
+    QTest::newRow( "long cyrillic" ) << QString::fromUtf8( "Ежеквартальный финансовый отчёт по северному региону окончательная исправленная версия.docx" );
+    QTest::newRow( "long cjk" ) << QString::fromUtf8( "北部地域の四半期財務報告書最終改訂版のコピーと添付資料一式をまとめたもの.pdf" );
+    QTest::newRow( "long arabic" ) << QString::fromUtf8( "التقرير المالي الفصلي للمنطقة الشمالية النسخة النهائية المنقحة.pdf" );
+    QTest::newRow( "long combining" ) << QString::fromUtf8( "Übersicht Prüfungsergebnisse résumé naïve café Ångström Tiếng Việt bản cuối cùng.txt" );
+    QTest::newRow( "long mixed" ) << QString::fromUtf8( "写真 Фото photo 사진 صورة φωτογραφία 2018-05-14 😀 holiday album final.jpg" );
+}
+
+/**
+ * @brief TextLayoutBenchmark::legacyLayout the old line breaking (measures every prefix of the
+ * remaining text, O(n²) per label)
+ * @param text
+ * @param fontMetrics
+ * @param width
+ * @param lineCount
+ * @return number of lines
+ */
+int TextLayoutBenchmark::legacyLayout( const QString &text, const QFontMetrics &fontMetrics, int width, int lineCount ) {
+    QString remaining( text );
+    QStringList lines;
+    int y, numLines = 0;
+
+    while ( lineCount - numLines ) {
+        for ( y = 0; y < remaining.length(); y++ ) {
+            if ( fontMetrics.width( remaining.left( y + 1 )) > width )
+                break;
+        }
+
+        if ( y > 0 ) {
+            if ( numLines < lineCount - 1 ) {
+                lines << remaining.left( y );
+                remaining = remaining.mid( y, remaining.length() - y );
+            } else
+                lines << fontMetrics.elidedText( remaining, Qt::ElideRight, width );
+        } else
+            break;
+
+        numLines++;
+    }
+
+    return lines.count();
+}
+
+/**
+ * @brief TextLayoutBenchmark::legacy
+ */
+void TextLayoutBenchmark::legacy() {
+    QFETCH( QString, text );
+    const QFontMetrics fontMetrics( this->font );
+    int lines = 0;
+
+    QBENCHMARK {
+        lines = TextLayoutBenchmark::legacyLayout( text, fontMetrics, TextLayoutBenchmarkNamespace::Width, FolderDelegateNamespace::TextLines );
+    }
+
+    QVERIFY( lines > 0 );
+}
+
+/**
+ * @brief TextLayoutBenchmark::layout uncached layout, as on first paint of a label
+ */
+void TextLayoutBenchmark::layout() {
+    QFETCH( QString, text );
+    ListItem item;
+    int y;
+
+    QBENCHMARK {
+        item = FolderDelegate::layoutText( text, this->font, TextLayoutBenchmarkNamespace::Width, FolderDelegateNamespace::TextLines );
+    }
+
+    QVERIFY( !item.lines.isEmpty());
+    QVERIFY( item.lines.count() <= FolderDelegateNamespace::TextLines );
+    for ( y = 0; y < item.lineWidths.count(); y++ )
+        QVERIFY( item.lineWidths.at( y ) <= TextLayoutBenchmarkNamespace::Width + 1 );
+}
+
+/**
+ * @brief TextLayoutBenchmark::cached cache hits on a warm layout cache (repaint of the same labels)
+ */
+void TextLayoutBenchmark::cached() {
+    QFETCH( QString, text );
+    QCache<ListItemKey, ListItem> cache( FolderDelegateNamespace::CachedLayouts );
+    ListItem *item = nullptr;
+    int y;
+
+    for ( y = 0; y < TextLayoutBenchmarkNamespace::LayoutCount; y++ )
+        cache.insert( ListItemKey( QString( "%1 %2" ).arg( text ).arg( y ), this->font, TextLayoutBenchmarkNamespace::Width, FolderDelegateNamespace::TextLines ), new ListItem());
+
+    QBENCHMARK {
+        for ( y = 0; y < TextLayoutBenchmarkNamespace::LayoutCount; y++ )
+            item = cache.object( ListItemKey( QString( "%1 %2" ).arg( text ).arg( y ), this->font, TextLayoutBenchmarkNamespace::Width, FolderDelegateNamespace::TextLines ));
+    }
+
+    QVERIFY( item != nullptr );
+}
+
+/**
+ * @brief main
+ * @param argc
+ * @param argv
+ * @return
+ */
+int main( int argc, char *argv[] ) {
+    // no display needed
+    if ( qEnvironmentVariableIsEmpty( "QT_QPA_PLATFORM" ))
+        qputenv( "QT_QPA_PLATFORM", "offscreen" );
+
+    QApplication app( argc, argv );
+    TextLayoutBenchmark benchmark;
+    return QTest::qExec( &benchmark, argc, argv );
+}
+
+#include "tst_textlayout.moc"
@@ -65,6 +65,9 @@ DesktopIcon::DesktopIcon( QWidget *parent, const QString &target, qreal padding,
     // set object name for styling
     this->setObjectName( "DesktopIcon" );
 
+    // icons loaded elsewhere at the same time arrive later
+    this->connect( IconCache::instance(), SIGNAL( imageReady( QString, int, QImage )), this, SLOT( imageReady( QString, int, QImage )));
+
     // set icon from target file or folder
     this->setCustomIcon( this->customIcon());
     if ( this->icon().isNull())
@@ -119,7 +122,7 @@ void DesktopIcon::setIcon() {
 #ifdef Q_OS_WIN
             // TODO: find a way to default to built-in directory icon if no custom icon is set
             if ( info.isDir())
-                icon = IconCache::instance()->extractPixmap( info.absoluteFilePath(), scale );
+                icon = QIcon( QPixmap::fromImage( IconCache::instance()->extractImage( info.absoluteFilePath(), scale )));
             else
 #endif
                 icon = IconCache::instance()->iconForFilename( info.absoluteFilePath(), scale, true );
@@ -131,6 +134,23 @@ void DesktopIcon::setIcon() {
     }
 }
 
+/**
+ * @brief DesktopIcon::imageReady sets the target icon once it has been loaded elsewhere
+ * @param fileName
+ * @param scale
+ * @param image
+ */
+void DesktopIcon::imageReady( const QString &fileName, int scale, const QImage &image ) {
+    if ( image.isNull() || !this->customIcon().isEmpty() || scale != static_cast<int>( this->iconSize() - this->padded() * 2 ))
+        return;
+
+    if ( QString::compare( fileName, QFileInfo( this->target()).absoluteFilePath()))
+        return;
+
+    this->m_icon = QIcon( QPixmap::fromImage( image ));
+    this->repaint();
+}
+
 /**
  * @brief DesktopIcon::setCustomIcon
  * @param icon
@@ -124,6 +124,9 @@ protected:
     void paintEvent( QPaintEvent *event );
     bool eventFilter( QObject *object, QEvent *event );
 
+private slots:
+    void imageReady( const QString &fileName, int scale, const QImage &image );
+
 private:
     QString m_target;
     QIcon m_icon;
@@ -0,0 +1,889 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFileSystemModel>
+#include <QMimeData>
+#include <QUrl>
+#include <QtConcurrent>
+#include "directorymodel.h"
+#include "filewatcher.h"
+#include <algorithm>
+#include <functional>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+/**
+ * @brief The DirectoryRecord struct (record returned by getdents64)
+ */
+struct DirectoryRecord {
+    quint64 inode;
+    qint64 offset;
+    unsigned short length;
+    unsigned char type;
+    char name[1];
+};
+
+/**
+ * @brief The DirectoryStat struct (subset of stat results the model stores)
+ */
+struct DirectoryStat {
+    DirectoryStat() : mode( 0 ), size( 0 ), modified( 0 ), device( 0 ), inode( 0 ) {}
+    quint32 mode;
+    qint64 size;
+    qint64 modified;
+    quint64 device;
+    quint64 inode;
+};
+
+/**
+ * @brief statAt stats a directory entry (statx where available)
+ * @param directory
+ * @param name
+ * @param follow follow symlinks
+ * @param out
+ * @return
+ */
+static bool statAt( int directory, const char *name, bool follow, DirectoryStat &out ) {
+#ifdef STATX_BASIC_STATS
+    struct statx buffer;
+
+    if ( statx( directory, name, AT_NO_AUTOMOUNT | ( follow ? 0 : AT_SYMLINK_NOFOLLOW ), STATX_TYPE | STATX_MODE | STATX_SIZE | STATX_MTIME | STATX_INO, &buffer ) != 0 )
+        return false;
+
+    out.mode = buffer.stx_mode;
+    out.size = static_cast<qint64>( buffer.stx_size );
+    out.modified = static_cast<qint64>( buffer.stx_mtime.tv_sec ) * 1000 + buffer.stx_mtime.tv_nsec / 1000000;
+    out.device = static_cast<quint64>( makedev( buffer.stx_dev_major, buffer.stx_dev_minor ));
+    out.inode = static_cast<quint64>( buffer.stx_ino );
+#else
+    struct stat buffer;
+
+    if ( fstatat( directory, name, &buffer, follow ? 0 : AT_SYMLINK_NOFOLLOW ) != 0 )
+        return false;
+
+    out.mode = buffer.st_mode;
+    out.size = static_cast<qint64>( buffer.st_size );
+    out.modified = static_cast<qint64>( buffer.st_mtim.tv_sec ) * 1000 + buffer.st_mtim.tv_nsec / 1000000;
+    out.device = static_cast<quint64>( buffer.st_dev );
+    out.inode = static_cast<quint64>( buffer.st_ino );
+#endif
+    return true;
+}
+
+/**
+ * @brief DirectoryEntries::append copies an entry from another list
+ * @param other
+ * @param row
+ */
+void DirectoryEntries::append( const DirectoryEntries &other, int row ) {
+    this->names << other.names.at( row );
+    this->targets << other.targets.at( row );
+    this->types << other.types.at( row );
+    this->symLinks << other.symLinks.at( row );
+    this->sizes << other.sizes.at( row );
+    this->modified << other.modified.at( row );
+    this->devices << other.devices.at( row );
+    this->inodes << other.inodes.at( row );
+    this->ids << other.ids.value( row, 0 );
+}
+
+/**
+ * @brief DirectoryEntries::replace updates an entry in place (keeps its id)
+ * @param row
+ * @param other
+ * @param otherRow
+ */
+void DirectoryEntries::replace( int row, const DirectoryEntries &other, int otherRow ) {
+    this->targets[row] = other.targets.at( otherRow );
+    this->types[row] = other.types.at( otherRow );
+    this->symLinks[row] = other.symLinks.at( otherRow );
+    this->sizes[row] = other.sizes.at( otherRow );
+    this->modified[row] = other.modified.at( otherRow );
+    this->devices[row] = other.devices.at( otherRow );
+    this->inodes[row] = other.inodes.at( otherRow );
+}
+
+/**
+ * @brief DirectoryEntries::remove
+ * @param row
+ */
+void DirectoryEntries::remove( int row ) {
+    this->names.removeAt( row );
+    this->targets.removeAt( row );
+    this->types.remove( row );
+    this->symLinks.remove( row );
+    this->sizes.remove( row );
+    this->modified.remove( row );
+    this->devices.remove( row );
+    this->inodes.remove( row );
+    this->ids.remove( row );
+}
+
+/**
+ * @brief DirectoryEntries::clear
+ */
+void DirectoryEntries::clear() {
+    this->names.clear();
+    this->targets.clear();
+    this->types.clear();
+    this->symLinks.clear();
+    this->sizes.clear();
+    this->modified.clear();
+    this->devices.clear();
+    this->inodes.clear();
+    this->ids.clear();
+}
+
+/**
+ * @brief DirectoryModel::DirectoryModel
+ * @param parent
+ */
+DirectoryModel::DirectoryModel( QObject *parent ) : QAbstractItemModel( parent ), m_rowsDirty( false ), m_nextId( 1 ), m_filters( QDir::AllEntries | QDir::NoDotAndDotDot ), m_readOnly( true ), m_scanning( false ), m_backlogFirst( 0 ), m_fetchRows( 0 ), m_retries( 0 ) {
+    this->connect( &this->scanWatcher, SIGNAL( finished()), this, SLOT( scanFinished()));
+
+    // listed entries are inserted in slices between events
+    this->fetchTimer.setSingleShot( true );
+    this->connect( &this->fetchTimer, SIGNAL( timeout()), this, SLOT( fetchSlice()));
+
+    // failed listings (e.g. out of descriptors) are retried a few times
+    this->retryTimer.setSingleShot( true );
+    this->retryTimer.setInterval( DirectoryModelNamespace::RetryInterval );
+    this->connect( &this->retryTimer, SIGNAL( timeout()), this, SLOT( startScan()));
+
+    // changes arrive in batches from the shared watcher
+    this->connect( FileWatcher::instance(), SIGNAL( changed( QString, QSet<QString> )), this, SLOT( directoryChanged( QString, QSet<QString> )));
+    this->connect( FileWatcher::instance(), SIGNAL( lost( QString )), this, SLOT( directoryLost( QString )));
+}
+
+/**
+ * @brief DirectoryModel::~DirectoryModel
+ */
+DirectoryModel::~DirectoryModel() {
+    // a running scan does not reference the model, its result is discarded
+    this->scanWatcher.disconnect( this );
+
+    this->unwatch();
+}
+
+/**
+ * @brief DirectoryModel::index
+ * @param row
+ * @param column
+ * @param parent
+ * @return
+ */
+QModelIndex DirectoryModel::index( int row, int column, const QModelIndex &parent ) const {
+    if ( column != 0 || row < 0 )
+        return QModelIndex();
+
+    // root directory is the only top level row
+    if ( !parent.isValid())
+        return row == 0 ? this->rootIndex() : QModelIndex();
+
+    if ( parent.internalId() != 0 || row >= this->entries.count())
+        return QModelIndex();
+
+    return this->createIndex( row, 0, this->entries.ids.at( row ));
+}
+
+/**
+ * @brief DirectoryModel::parent
+ * @param index
+ * @return
+ */
+QModelIndex DirectoryModel::parent( const QModelIndex &index ) const {
+    if ( !index.isValid() || index.internalId() == 0 )
+        return QModelIndex();
+
+    return this->rootIndex();
+}
+
+/**
+ * @brief DirectoryModel::rowCount
+ * @param parent
+ * @return
+ */
+int DirectoryModel::rowCount( const QModelIndex &parent ) const {
+    if ( !parent.isValid())
+        return this->m_rootPath.isEmpty() ? 0 : 1;
+
+    return parent.internalId() == 0 ? this->entries.count() : 0;
+}
+
+/**
+ * @brief DirectoryModel::hasChildren
+ * @param parent
+ * @return
+ */
+bool DirectoryModel::hasChildren( const QModelIndex &parent ) const {
+    if ( !parent.isValid())
+        return !this->m_rootPath.isEmpty();
+
+    return parent.internalId() == 0;
+}
+
+/**
+ * @brief DirectoryModel::canFetchMore returns true if listed entries are waiting for insertion
+ * (and no fetch is in progress)
+ * @param parent
+ * @return
+ */
+bool DirectoryModel::canFetchMore( const QModelIndex &parent ) const {
+    if ( !parent.isValid() || parent.internalId() != 0 )
+        return false;
+
+    return this->m_fetchRows == 0 && !this->backlogNames.isEmpty();
+}
+
+/**
+ * @brief DirectoryModel::fetchMore inserts the next chunk of listed entries (asynchronously)
+ * @param parent
+ */
+void DirectoryModel::fetchMore( const QModelIndex &parent ) {
+    if ( !this->canFetchMore( parent ))
+        return;
+
+    this->m_fetchRows = DirectoryModelNamespace::FetchRows;
+    this->fetchTimer.start( 0 );
+}
+
+/**
+ * @brief DirectoryModel::fetchSlice inserts requested entries until the frame budget is spent
+ * (the budget includes the work views and proxies do on insertion)
+ */
+void DirectoryModel::fetchSlice() {
+    DirectoryEntries list;
+    QElapsedTimer timer;
+    int y;
+
+    timer.start();
+    while ( this->m_fetchRows > 0 && this->m_backlogFirst < this->backlog.count()) {
+        list.clear();
+
+        for ( y = 0; y < DirectoryModelNamespace::SliceRows && this->m_fetchRows > 0 && this->m_backlogFirst < this->backlog.count(); this->m_backlogFirst++ ) {
+            // entry was changed or removed since the scan and is already handled
+            if ( !this->backlogNames.remove( this->backlog.names.at( this->m_backlogFirst )))
+                continue;
+
+            list.append( this->backlog, this->m_backlogFirst );
+            this->m_fetchRows--;
+            y++;
+        }
+
+        this->insertEntries( list );
+        if ( timer.elapsed() >= DirectoryModelNamespace::SliceBudget )
+            break;
+    }
+
+    if ( this->m_backlogFirst >= this->backlog.count()) {
+        this->clearBacklog();
+        return;
+    }
+
+    // continue in the next slice, let the event loop paint in between
+    if ( this->m_fetchRows > 0 )
+        this->fetchTimer.start( 0 );
+}
+
+/**
+ * @brief DirectoryModel::clearBacklog drops listed entries that were not inserted
+ */
+void DirectoryModel::clearBacklog() {
+    this->fetchTimer.stop();
+    this->backlog.clear();
+    this->backlogNames.clear();
+    this->m_backlogFirst = 0;
+    this->m_fetchRows = 0;
+}
+
+/**
+ * @brief DirectoryModel::fileName
+ * @param index
+ * @return
+ */
+QString DirectoryModel::fileName( const QModelIndex &index ) const {
+    if ( !this->isEntry( index ))
+        return this->rootDirectory().dirName();
+
+    return this->entries.names.at( index.row());
+}
+
+/**
+ * @brief DirectoryModel::filePath
+ * @param index
+ * @return
+ */
+QString DirectoryModel::filePath( const QModelIndex &index ) const {
+    if ( !this->isEntry( index ))
+        return this->m_rootPath;
+
+    if ( this->m_rootPath.endsWith( "/" ))
+        return this->m_rootPath + this->entries.names.at( index.row());
+
+    return this->m_rootPath + "/" + this->entries.names.at( index.row());
+}
+
+/**
+ * @brief DirectoryModel::isDir
+ * @param index
+ * @return
+ */
+bool DirectoryModel::isDir( const QModelIndex &index ) const {
+    if ( !this->isEntry( index ))
+        return index.isValid();
+
+    return this->entries.types.at( index.row()) == FileMeta::Directory;
+}
+
+/**
+ * @brief DirectoryModel::fileMeta builds metadata from stored stat results (no syscalls)
+ * @param index
+ * @return
+ */
+FileMeta DirectoryModel::fileMeta( const QModelIndex &index ) const {
+    FileMeta meta;
+    int row;
+
+    if ( !this->isEntry( index )) {
+        if ( index.isValid())
+            return FileMeta::fromFileInfo( QFileInfo( this->m_rootPath ));
+
+        return meta;
+    }
+
+    row = index.row();
+    meta.filePath = this->filePath( index );
+    meta.target = this->entries.targets.at( row );
+    meta.type = static_cast<FileMeta::Types>( this->entries.types.at( row ));
+    meta.symLink = this->entries.symLinks.at( row );
+    meta.hidden = this->entries.names.at( row ).startsWith( "." );
+    meta.size = this->entries.sizes.at( row );
+    meta.modified = this->entries.modified.at( row );
+    meta.device = this->entries.devices.at( row );
+    meta.inode = this->entries.inodes.at( row );
+
+    return meta;
+}
+
+/**
+ * @brief DirectoryModel::data
+ * @param index
+ * @param role
+ * @return
+ */
+QVariant DirectoryModel::data( const QModelIndex &index, int role ) const {
+    if ( !index.isValid() || ( index.internalId() != 0 && !this->isEntry( index )))
+        return QVariant();
+
+    switch ( role ) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+    case QFileSystemModel::FileNameRole:
+        return this->fileName( index );
+
+    case QFileSystemModel::FilePathRole:
+        return this->filePath( index );
+
+    case Qt::DecorationRole:
+        // generic placeholder, actual icons are provided by the proxy model
+        return this->iconProvider.icon( this->isDir( index ) ? QFileIconProvider::Folder : QFileIconProvider::File );
+
+    case FileMetaNamespace::FileMetaRole:
+        return QVariant::fromValue( this->fileMeta( index ));
+
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+/**
+ * @brief DirectoryModel::mimeData
+ * @param indexes
+ * @return
+ */
+QMimeData *DirectoryModel::mimeData( const QModelIndexList &indexes ) const {
+    QMimeData *data = new QMimeData();
+    QList<QUrl> urls;
+
+    foreach ( const QModelIndex &index, indexes ) {
+        if ( this->isEntry( index ))
+            urls << QUrl::fromLocalFile( this->filePath( index ));
+    }
+
+    data->setUrls( urls );
+    return data;
+}
+
+/**
+ * @brief DirectoryModel::dropMimeData copies, moves or links dropped files (same as QFileSystemModel)
+ * @param data
+ * @param action
+ * @param row
+ * @param column
+ * @param parent
+ * @return
+ */
+bool DirectoryModel::dropMimeData( const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent ) {
+    bool success = true;
+    QString target;
+
+    Q_UNUSED( row )
+    Q_UNUSED( column )
+
+    if ( !parent.isValid() || this->isReadOnly() || !data->hasUrls())
+        return false;
+
+    // dropped on a file, use root directory instead
+    target = this->isDir( parent ) ? this->filePath( parent ) : this->m_rootPath;
+
+    foreach ( const QUrl &url, data->urls()) {
+        const QString fileName( url.toLocalFile());
+        const QString destination( target + "/" + QFileInfo( fileName ).fileName());
+
+        switch ( action ) {
+        case Qt::CopyAction:
+            success = QFile::copy( fileName, destination ) && success;
+            break;
+
+        case Qt::LinkAction:
+            success = QFile::link( fileName, destination ) && success;
+            break;
+
+        case Qt::MoveAction:
+            success = QFile::rename( fileName, destination ) && success;
+            break;
+
+        default:
+            return false;
+        }
+    }
+
+    return success;
+}
+
+/**
+ * @brief DirectoryModel::setRootPath lists a new directory (asynchronously), root index stays the same
+ * @param path
+ * @return
+ */
+QModelIndex DirectoryModel::setRootPath( const QString &path ) {
+    const QString rootPath( QDir::cleanPath( QDir( path ).absolutePath()));
+
+    if ( !QString::compare( rootPath, this->m_rootPath ))
+        return this->rootIndex();
+
+    // drop previous listing
+    this->unwatch();
+    this->removeEntries();
+
+    if ( this->m_rootPath.isEmpty()) {
+        this->beginInsertRows( QModelIndex(), 0, 0 );
+        this->m_rootPath = rootPath;
+        this->endInsertRows();
+    } else {
+        this->m_rootPath = rootPath;
+        emit this->dataChanged( this->rootIndex(), this->rootIndex());
+    }
+
+    // watch before listing, so that no changes are lost in between
+    this->m_retries = 0;
+    this->watch();
+    this->startScan();
+
+    return this->rootIndex();
+}
+
+/**
+ * @brief DirectoryModel::scan enumerates a directory with getdents64 (runs in a worker thread)
+ * @param path
+ * @param hidden include hidden files
+ * @return
+ */
+DirectoryEntries DirectoryModel::scan( const QString &path, bool hidden ) {
+    alignas( 8 ) char buffer[DirectoryModelNamespace::BufferSize];
+    DirectoryEntries list;
+    long bytes, offset;
+    int directory;
+
+    list.path = path;
+    directory = open( QFile::encodeName( path ).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+    if ( directory < 0 ) {
+        list.error = errno;
+        return list;
+    }
+
+    list.valid = true;
+    while (( bytes = syscall( SYS_getdents64, directory, buffer, sizeof( buffer ))) > 0 ) {
+        for ( offset = 0; offset < bytes; ) {
+            const DirectoryRecord *record = reinterpret_cast<const DirectoryRecord*>( buffer + offset );
+            const char *name = record->name;
+
+            offset += record->length;
+
+            // skip '.', '..' and (optionally) hidden files
+            if ( name[0] == '.' && ( !hidden || name[1] == '\0' || ( name[1] == '.' && name[2] == '\0' )))
+                continue;
+
+            DirectoryModel::statEntry( directory, path, QByteArray( name ), list );
+        }
+    }
+    close( directory );
+
+    return list;
+}
+
+/**
+ * @brief DirectoryModel::statEntry stats a single entry and appends it to the list
+ * NOTE: only symlinks cost extra syscalls here (readlink and a stat of the target)
+ * @param directory open directory descriptor
+ * @param path directory path
+ * @param name
+ * @param entries
+ * @return false if entry does not exist
+ */
+bool DirectoryModel::statEntry( int directory, const QString &path, const QByteArray &name, DirectoryEntries &entries ) {
+    DirectoryStat status;
+    QString target;
+    bool symLink;
+
+    if ( !statAt( directory, name.constData(), false, status ))
+        return false;
+
+    // resolve link target (broken links keep the link's own data)
+    symLink = S_ISLNK( status.mode );
+    if ( symLink ) {
+        char link[PATH_MAX];
+        const ssize_t length = readlinkat( directory, name.constData(), link, sizeof( link ) - 1 );
+
+        if ( length > 0 ) {
+            target = QFile::decodeName( QByteArray( link, static_cast<int>( length )));
+            if ( QDir::isRelativePath( target ))
+                target = path + "/" + target;
+
+            target = QDir::cleanPath( target );
+        }
+
+        statAt( directory, name.constData(), true, status );
+    }
+
+    entries.names << QFile::decodeName( name );
+    entries.targets << target;
+    entries.types << static_cast<qint8>( S_ISDIR( status.mode ) ? FileMeta::Directory : FileMeta::File );
+    entries.symLinks << symLink;
+    entries.sizes << status.size;
+    entries.modified << status.modified;
+    entries.devices << status.device;
+    entries.inodes << status.inode;
+
+    return true;
+}
+
+/**
+ * @brief DirectoryModel::startScan
+ */
+void DirectoryModel::startScan() {
+    this->retryTimer.stop();
+    this->m_scanning = true;
+    this->pending.clear();
+    this->scanWatcher.setFuture( QtConcurrent::run( &DirectoryModel::scan, this->m_rootPath, this->m_filters.testFlag( QDir::Hidden )));
+}
+
+/**
+ * @brief DirectoryModel::scanFinished updates listed entries with scan results and queues the
+ * new ones for insertion, then applies changes that were reported while scanning
+ */
+void DirectoryModel::scanFinished() {
+    DirectoryEntries list( this->scanWatcher.result());
+    DirectoryEntries known;
+    QStringList removed;
+    int y;
+
+    // stale scan of a previous root
+    if ( QString::compare( list.path, this->m_rootPath ))
+        return;
+
+    // listing failed, an empty result does not mean that all entries were removed
+    if ( !list.valid ) {
+        if ( list.error == ENOENT || list.error == ENOTDIR ) {
+            this->m_scanning = false;
+            this->m_retries = 0;
+            this->pending.clear();
+            this->removeEntries();
+            return;
+        }
+
+        qWarning() << this->tr( "could not list \"%1\": %2" ).arg( list.path ).arg( qt_error_string( list.error ));
+
+        // keep listed entries, changes reported in the meantime are covered by the next scan
+        if ( this->m_retries < DirectoryModelNamespace::MaximumRetries ) {
+            this->m_retries++;
+            this->retryTimer.start();
+        } else {
+            this->m_scanning = false;
+            this->pending.clear();
+        }
+        return;
+    }
+
+    this->m_scanning = false;
+    this->m_retries = 0;
+    this->clearBacklog();
+
+    // rescan (e.g. after lost events), apply only the differences
+    if ( this->entries.count()) {
+        const QSet<QString> names( list.names.constBegin(), list.names.constEnd());
+
+        foreach ( const QString &name, this->entries.names ) {
+            if ( !names.contains( name ))
+                removed << name;
+        }
+
+        for ( y = 0; y < list.count(); y++ ) {
+            if ( this->rowForName( list.names.at( y )) >= 0 ) {
+                known.append( list, y );
+            } else {
+                this->backlog.append( list, y );
+                this->backlogNames << list.names.at( y );
+            }
+        }
+
+        this->updateEntries( known, removed );
+    } else {
+        this->backlog = list;
+        this->backlogNames = QSet<QString>( list.names.constBegin(), list.names.constEnd());
+    }
+
+    // first chunk is inserted right away, views fetch the rest as they need it
+    this->fetchMore( this->rootIndex());
+
+    if ( !this->pending.isEmpty()) {
+        this->applyChanges( this->pending );
+        this->pending.clear();
+    }
+}
+
+/**
+ * @brief DirectoryModel::insertEntries appends entries (assigns ids)
+ * @param list
+ */
+void DirectoryModel::insertEntries( DirectoryEntries &list ) {
+    int y;
+
+    if ( !list.count())
+        return;
+
+    list.ids.resize( list.count());
+    for ( y = 0; y < list.count(); y++ )
+        list.ids[y] = this->m_nextId++;
+
+    this->beginInsertRows( this->rootIndex(), this->entries.count(), this->entries.count() + list.count() - 1 );
+    if ( !this->entries.count()) {
+        this->entries = list;
+        this->m_rowsDirty = true;
+    } else {
+        for ( y = 0; y < list.count(); y++ ) {
+            if ( !this->m_rowsDirty )
+                this->rows[list.names.at( y )] = this->entries.count();
+
+            this->entries.append( list, y );
+        }
+    }
+    this->endInsertRows();
+}
+
+/**
+ * @brief DirectoryModel::removeEntries
+ */
+void DirectoryModel::removeEntries() {
+    this->clearBacklog();
+
+    if ( !this->entries.count())
+        return;
+
+    this->beginRemoveRows( this->rootIndex(), 0, this->entries.count() - 1 );
+    this->entries.clear();
+    this->rows.clear();
+    this->m_rowsDirty = false;
+    this->endRemoveRows();
+}
+
+/**
+ * @brief DirectoryModel::rowForName maps entry name to row (mapping is rebuilt lazily after removals)
+ * @param name
+ * @return
+ */
+int DirectoryModel::rowForName( const QString &name ) {
+    int y;
+
+    if ( this->m_rowsDirty ) {
+        this->rows.clear();
+        this->rows.reserve( this->entries.count());
+        for ( y = 0; y < this->entries.count(); y++ )
+            this->rows[this->entries.names.at( y )] = y;
+
+        this->m_rowsDirty = false;
+    }
+
+    return this->rows.value( name, -1 );
+}
+
+/**
+ * @brief DirectoryModel::updateEntries removes, updates and appends entries
+ * @param list current state of changed entries
+ * @param removed names of entries that no longer exist
+ */
+void DirectoryModel::updateEntries( const DirectoryEntries &list, const QStringList &removed ) {
+    DirectoryEntries added;
+    QList<int> removedRows;
+    int y, row;
+
+    foreach ( const QString &name, removed ) {
+        row = this->rowForName( name );
+        if ( row >= 0 )
+            removedRows << row;
+    }
+
+    // entries that changed their type are removed and added again (sort keys depend on the type)
+    for ( y = 0; y < list.count(); y++ ) {
+        row = this->rowForName( list.names.at( y ));
+        if ( row >= 0 && list.types.at( y ) != this->entries.types.at( row ))
+            removedRows << row;
+    }
+
+    // remove from the end, so that rows stay valid (name mapping is rebuilt once afterwards)
+    std::sort( removedRows.begin(), removedRows.end(), std::greater<int>());
+    removedRows.erase( std::unique( removedRows.begin(), removedRows.end()), removedRows.end());
+    foreach ( row, removedRows ) {
+        this->beginRemoveRows( this->rootIndex(), row, row );
+        this->entries.remove( row );
+        this->m_rowsDirty = true;
+        this->endRemoveRows();
+    }
+
+    for ( y = 0; y < list.count(); y++ ) {
+        row = this->rowForName( list.names.at( y ));
+
+        if ( row < 0 ) {
+            added.append( list, y );
+            continue;
+        }
+
+        if ( list.modified.at( y ) != this->entries.modified.at( row ) || list.sizes.at( y ) != this->entries.sizes.at( row ) || list.inodes.at( y ) != this->entries.inodes.at( row ) || QString::compare( list.targets.at( y ), this->entries.targets.at( row ))) {
+            const QModelIndex index( this->index( row, 0, this->rootIndex()));
+
+            this->entries.replace( row, list, y );
+            emit this->dataChanged( index, index );
+        }
+    }
+
+    // new entries are appended in one go
+    this->insertEntries( added );
+}
+
+/**
+ * @brief DirectoryModel::applyChanges stats changed entries and updates, inserts or removes them
+ * @param names
+ */
+void DirectoryModel::applyChanges( const QSet<QString> &names ) {
+    DirectoryEntries list;
+    QStringList removed;
+    int directory;
+
+    directory = open( QFile::encodeName( this->m_rootPath ).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC );
+    if ( directory < 0 )
+        return;
+
+    foreach ( const QString &name, names ) {
+        if ( this->isFiltered( name ))
+            continue;
+
+        // entries waiting for insertion are handled as new ones
+        this->backlogNames.remove( name );
+
+        if ( !DirectoryModel::statEntry( directory, this->m_rootPath, QFile::encodeName( name ), list ))
+            removed << name;
+    }
+    close( directory );
+
+    this->updateEntries( list, removed );
+}
+
+/**
+ * @brief DirectoryModel::directoryChanged applies a batch of changed names
+ * @param path
+ * @param names
+ */
+void DirectoryModel::directoryChanged( const QString &path, const QSet<QString> &names ) {
+    // changes of another directory
+    if ( QString::compare( path, this->m_watchPath ) || names.isEmpty())
+        return;
+
+    // scan results might not include these yet
+    if ( this->m_scanning ) {
+        this->pending.unite( names );
+        return;
+    }
+
+    this->applyChanges( names );
+}
+
+/**
+ * @brief DirectoryModel::directoryLost lists the directory again after lost events or if it
+ * was removed or moved
+ * @param path
+ */
+void DirectoryModel::directoryLost( const QString &path ) {
+    if ( QString::compare( path, this->m_watchPath ))
+        return;
+
+    this->startScan();
+}
+
+/**
+ * @brief DirectoryModel::watch
+ */
+void DirectoryModel::watch() {
+    if ( this->m_rootPath.isEmpty())
+        return;
+
+    this->m_watchPath = this->m_rootPath;
+    FileWatcher::instance()->watch( this->m_watchPath );
+}
+
+/**
+ * @brief DirectoryModel::unwatch
+ */
+void DirectoryModel::unwatch() {
+    if ( this->m_watchPath.isEmpty())
+        return;
+
+    FileWatcher::instance()->unwatch( this->m_watchPath );
+    this->m_watchPath.clear();
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QAbstractItemModel>
+#include <QDir>
+#include <QFileIconProvider>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
+#include "filemeta.h"
+
+/**
+ * @brief The DirectoryModelNamespace namespace
+ */
+namespace DirectoryModelNamespace {
+static const int BufferSize = 32768;
+static const int FetchRows = 2048;
+static const int SliceRows = 256;
+static const int SliceBudget = 8;
+static const int RetryInterval = 1000;
+static const int MaximumRetries = 5;
+}
+
+/**
+ * @brief The DirectoryEntries struct flat directory listing stored as struct-of-arrays
+ * (ids are assigned by the model and stay the same while an entry exists)
+ */
+struct DirectoryEntries {
+    DirectoryEntries() : valid( false ), error( 0 ) {}
+    int count() const { return this->names.count(); }
+    void append( const DirectoryEntries &other, int row );
+    void replace( int row, const DirectoryEntries &other, int otherRow );
+    void remove( int row );
+    void clear();
+    QString path;
+    bool valid;
+    int error;
+    QStringList names;
+    QStringList targets;
+    QVector<qint8> types;
+    QVector<bool> symLinks;
+    QVector<qint64> sizes;
+    QVector<qint64> modified;
+    QVector<quint64> devices;
+    QVector<quint64> inodes;
+    QVector<quintptr> ids;
+};
+
+/**
+ * @brief The DirectoryModel class flat, single directory model (Linux only)
+ *
+ * NOTE: drop-in for the subset of QFileSystemModel used by views; the root directory is the
+ *       only top level row, its entries are enumerated in a worker (getdents64/statx),
+ *       inserted in time sliced chunks as views fetch them and kept up to date with batched
+ *       deltas from the shared FileWatcher
+ */
+class DirectoryModel : public QAbstractItemModel {
+    Q_OBJECT
+    Q_DISABLE_COPY( DirectoryModel )
+
+public:
+    explicit DirectoryModel( QObject *parent = nullptr );
+    ~DirectoryModel();
+    QModelIndex index( int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    QModelIndex parent( const QModelIndex &index ) const;
+    int rowCount( const QModelIndex &parent = QModelIndex()) const;
+    int columnCount( const QModelIndex &parent = QModelIndex()) const { Q_UNUSED( parent ) return 1; }
+    bool hasChildren( const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore( const QModelIndex &parent ) const;
+    void fetchMore( const QModelIndex &parent );
+    QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const;
+    QStringList mimeTypes() const { return QStringList() << "text/uri-list"; }
+    QMimeData *mimeData( const QModelIndexList &indexes ) const;
+    bool dropMimeData( const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent );
+    QModelIndex setRootPath( const QString &path );
+    QString rootPath() const { return this->m_rootPath; }
+    QDir rootDirectory() const { return QDir( this->m_rootPath ); }
+    QModelIndex rootIndex() const { return this->m_rootPath.isEmpty() ? QModelIndex() : this->createIndex( 0, 0, quintptr( 0 )); }
+    void setFilter( QDir::Filters filters ) { this->m_filters = filters; }
+    QDir::Filters filter() const { return this->m_filters; }
+    void setReadOnly( bool enable ) { this->m_readOnly = enable; }
+    bool isReadOnly() const { return this->m_readOnly; }
+    QString fileName( const QModelIndex &index ) const;
+    QString filePath( const QModelIndex &index ) const;
+    bool isDir( const QModelIndex &index ) const;
+    FileMeta fileMeta( const QModelIndex &index ) const;
+    static DirectoryEntries scan( const QString &path, bool hidden );
+
+private slots:
+    void scanFinished();
+    void fetchSlice();
+    void directoryChanged( const QString &path, const QSet<QString> &names );
+    void directoryLost( const QString &path );
+    void startScan();
+
+private:
+    static bool statEntry( int directory, const QString &path, const QByteArray &name, DirectoryEntries &entries );
+    bool isEntry( const QModelIndex &index ) const { return index.isValid() && index.internalId() != 0 && index.row() >= 0 && index.row() < this->entries.count(); }
+    bool isFiltered( const QString &name ) const { return name.startsWith( "." ) && !this->m_filters.testFlag( QDir::Hidden ); }
+    int rowForName( const QString &name );
+    void insertEntries( DirectoryEntries &list );
+    void removeEntries();
+    void clearBacklog();
+    void updateEntries( const DirectoryEntries &list, const QStringList &removed );
+    void applyChanges( const QSet<QString> &names );
+    void watch();
+    void unwatch();
+    DirectoryEntries entries;
+    QHash<QString, int> rows;
+    bool m_rowsDirty;
+    quintptr m_nextId;
+    QString m_rootPath;
+    QDir::Filters m_filters;
+    bool m_readOnly;
+    QFutureWatcher<DirectoryEntries> scanWatcher;
+    bool m_scanning;
+    QSet<QString> pending;
+    DirectoryEntries backlog;
+    QSet<QString> backlogNames;
+    int m_backlogFirst;
+    int m_fetchRows;
+    QTimer fetchTimer;
+    QTimer retryTimer;
+    int m_retries;
+    QString m_watchPath;
+    QFileIconProvider iconProvider;
+};
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDateTime>
+#include <QDebug>
+#include <QFileSystemModel>
+#include "filefilter.h"
+#include <algorithm>
+
+/**
+ * @brief FileFilterRules::patterns returns patterns as edited by the user ('!' marks excludes)
+ * @return
+ */
+QString FileFilterRules::patterns() const {
+    QStringList patterns( this->includes );
+
+    foreach ( const QString &pattern, this->excludes )
+        patterns << "!" + pattern;
+
+    return patterns.join( "; " );
+}
+
+/**
+ * @brief FileFilterRules::setPatterns parses patterns separated by semicolons
+ * @param patterns
+ */
+void FileFilterRules::setPatterns( const QString &patterns ) {
+    this->includes.clear();
+    this->excludes.clear();
+
+    foreach ( QString pattern, patterns.split( ";", QString::SkipEmptyParts )) {
+        pattern = pattern.trimmed();
+
+        if ( pattern.startsWith( "!" )) {
+            pattern = pattern.mid( 1 ).trimmed();
+            if ( !pattern.isEmpty())
+                this->excludes << pattern;
+        } else if ( !pattern.isEmpty()) {
+            this->includes << pattern;
+        }
+    }
+}
+
+/**
+ * @brief FileFilterToken::matches
+ * @param ch
+ * @return
+ */
+bool FileFilterToken::matches( const QChar &ch ) const {
+    bool found = false;
+    int y;
+
+    switch ( this->type ) {
+    case Literal:
+        return this->set.at( 0 ) == ch;
+
+    case Any:
+    case Star:
+        return true;
+
+    case Set:
+        for ( y = 0; y < this->set.length() && !found; y++ ) {
+            if ( y + 2 < this->set.length() && this->set.at( y + 1 ) == '-' ) {
+                found = ch >= this->set.at( y ) && ch <= this->set.at( y + 2 );
+                y += 2;
+            } else {
+                found = this->set.at( y ) == ch;
+            }
+        }
+        return found != this->negated;
+
+    case End:
+        break;
+    }
+
+    return false;
+}
+
+/**
+ * @brief FileFilterGlobs::compile parses globs ('*', '?', '[set]', '[!set]') into tokens of
+ * a single automaton
+ * @param patterns
+ */
+void FileFilterGlobs::compile( const QStringList &patterns ) {
+    int y, end;
+
+    this->tokens.clear();
+    this->starts.clear();
+
+    foreach ( const QString &glob, patterns ) {
+        const QString pattern( FileFilter::fold( glob ));
+
+        this->starts << this->tokens.count();
+        for ( y = 0; y < pattern.length(); y++ ) {
+            const QChar ch( pattern.at( y ));
+
+            if ( ch == '*' ) {
+                // consecutive stars are the same as one
+                if ( this->tokens.count() == this->starts.last() || this->tokens.last().type != FileFilterToken::Star )
+                    this->tokens << FileFilterToken( FileFilterToken::Star );
+            } else if ( ch == '?' ) {
+                this->tokens << FileFilterToken( FileFilterToken::Any );
+            } else if ( ch == '[' && ( end = pattern.indexOf( ']', y + 2 )) > 0 ) {
+                const QString set( pattern.mid( y + 1, end - y - 1 ));
+
+                if ( set.startsWith( "!" ) && set.length() > 1 )
+                    this->tokens << FileFilterToken( FileFilterToken::Set, set.mid( 1 ), true );
+                else
+                    this->tokens << FileFilterToken( FileFilterToken::Set, set );
+                y = end;
+            } else {
+                this->tokens << FileFilterToken( FileFilterToken::Literal, ch );
+            }
+        }
+        this->tokens << FileFilterToken( FileFilterToken::End );
+    }
+
+    this->reset();
+}
+
+/**
+ * @brief FileFilterGlobs::reset drops cached states (keeps the start state)
+ */
+void FileFilterGlobs::reset() const {
+    this->states.clear();
+    this->stateIds.clear();
+
+    if ( !this->tokens.isEmpty())
+        this->state( this->starts );
+}
+
+/**
+ * @brief FileFilterGlobs::closure adds positions reachable without consuming a character
+ * (a star might match nothing)
+ * @param positions
+ */
+void FileFilterGlobs::closure( QVector<int> &positions ) const {
+    int y;
+
+    for ( y = 0; y < positions.count(); y++ ) {
+        if ( this->tokens.at( positions.at( y )).type == FileFilterToken::Star && !positions.contains( positions.at( y ) + 1 ))
+            positions << positions.at( y ) + 1;
+    }
+
+    std::sort( positions.begin(), positions.end());
+}
+
+/**
+ * @brief FileFilterGlobs::state returns (or creates) the state of a set of positions
+ * @param positions
+ * @return
+ */
+int FileFilterGlobs::state( QVector<int> positions ) const {
+    bool accepting = false;
+    int id;
+
+    this->closure( positions );
+
+    id = this->stateIds.value( positions, -1 );
+    if ( id >= 0 )
+        return id;
+
+    foreach ( int position, positions ) {
+        if ( this->tokens.at( position ).type == FileFilterToken::End ) {
+            accepting = true;
+            break;
+        }
+    }
+
+    id = this->states.count();
+    this->states << FileFilterState( positions, accepting );
+    this->stateIds[positions] = id;
+
+    return id;
+}
+
+/**
+ * @brief FileFilterGlobs::matches
+ * @param name folded file name
+ * @return
+ */
+bool FileFilterGlobs::matches( const QString &name ) const {
+    int y, current = 0;
+
+    if ( this->tokens.isEmpty())
+        return false;
+
+    // bound the cache (a single name adds at most one state per character)
+    if ( this->states.count() > FileFilterNamespace::MaximumStates )
+        this->reset();
+
+    for ( y = 0; y < name.length(); y++ ) {
+        const QChar ch( name.at( y ));
+        int next = this->states.at( current ).next.value( ch, -1 );
+
+        // build the transition once
+        if ( next < 0 ) {
+            QVector<int> positions;
+
+            foreach ( int position, this->states.at( current ).positions ) {
+                const FileFilterToken &token( this->tokens.at( position ));
+
+                int target;
+
+                if ( token.type == FileFilterToken::End || !token.matches( ch ))
+                    continue;
+
+                // star consumes the character and stays, others advance
+                target = token.type == FileFilterToken::Star ? position : position + 1;
+                if ( !positions.contains( target ))
+                    positions << target;
+            }
+
+            next = this->state( positions );
+            this->states[current].next[ch] = next;
+        }
+
+        current = next;
+
+        // no pattern can match anymore
+        if ( this->states.at( current ).positions.isEmpty())
+            return false;
+    }
+
+    return this->states.at( current ).accepting;
+}
+
+/**
+ * @brief FileFilter::fold makes names comparable (file names are case insensitive on Windows)
+ * @param name
+ * @return
+ */
+QString FileFilter::fold( const QString &name ) {
+#ifdef Q_OS_WIN
+    return name.toCaseFolded();
+#else
+    return name;
+#endif
+}
+
+/**
+ * @brief FileFilter::setRules compiles filter rules
+ * @param rules
+ */
+void FileFilter::setRules( const FileFilterRules &rules ) {
+    this->m_rules = rules;
+    this->includes.compile( rules.includes );
+    this->excludes.compile( rules.excludes );
+    this->m_empty = rules.hidden && this->includes.isEmpty() && this->excludes.isEmpty() && rules.maximumSize <= 0 && rules.maximumAge <= 0;
+
+    // hidden files are dotfiles on unix, other rules need the cached metadata of the source model
+#ifdef Q_OS_WIN
+    this->m_needsMeta = !rules.hidden || !this->includes.isEmpty() || rules.maximumSize > 0 || rules.maximumAge > 0;
+#else
+    this->m_needsMeta = !this->includes.isEmpty() || rules.maximumSize > 0 || rules.maximumAge > 0;
+#endif
+}
+
+/**
+ * @brief FileFilter::accepts matches a source model entry (name and cached metadata only)
+ * @param index
+ * @return
+ */
+bool FileFilter::accepts( const QModelIndex &index ) const {
+    if ( this->isEmpty())
+        return true;
+
+    return this->accepts( index.data( QFileSystemModel::FileNameRole ).toString(),
+                          this->m_needsMeta ? qvariant_cast<FileMeta>( index.data( FileMetaNamespace::FileMetaRole )) : FileMeta());
+}
+
+/**
+ * @brief FileFilter::accepts excludes and hidden files apply to all entries, includes and
+ * limits to files only (directories stay reachable)
+ * @param name
+ * @param meta
+ * @return
+ */
+bool FileFilter::accepts( const QString &name, const FileMeta &meta ) const {
+    const QString folded( FileFilter::fold( name ));
+
+    if ( this->isEmpty())
+        return true;
+
+    if ( !this->m_rules.hidden && ( name.startsWith( "." ) || meta.hidden ))
+        return false;
+
+    if ( !this->excludes.isEmpty() && this->excludes.matches( folded ))
+        return false;
+
+    if ( meta.isDir())
+        return true;
+
+    if ( !this->includes.isEmpty() && !this->includes.matches( folded ))
+        return false;
+
+    if ( this->m_rules.maximumSize > 0 && meta.size > this->m_rules.maximumSize )
+        return false;
+
+    if ( this->m_rules.maximumAge > 0 && QDateTime::currentMSecsSinceEpoch() - meta.modified > this->m_rules.maximumAge * FileFilterNamespace::Day )
+        return false;
+
+    return true;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QModelIndex>
+#include <QStringList>
+#include <QVector>
+#include "filemeta.h"
+
+/**
+ * @brief The FileFilterNamespace namespace
+ */
+namespace FileFilterNamespace {
+static const qint64 Day = 86400000;
+static const qint64 MegaByte = 1048576;
+}
+
+/**
+ * @brief The FileFilterRules struct (per view filter settings as configured by the user)
+ */
+struct FileFilterRules {
+    FileFilterRules() : hidden( false ), maximumSize( 0 ), maximumAge( 0 ) {}
+    bool isDefault() const { return this->includes.isEmpty() && this->excludes.isEmpty() && !this->hidden && this->maximumSize <= 0 && this->maximumAge <= 0; }
+    QString patterns() const;
+    void setPatterns( const QString &patterns );
+    QStringList includes;
+    QStringList excludes;
+    bool hidden;
+    qint64 maximumSize;
+    int maximumAge;
+};
+
+/**
+ * @brief The FileFilterToken struct (single glob element)
+ */
+struct FileFilterToken {
+    enum Types {
+        Literal = 0,
+        Any,
+        Star,
+        Set,
+        End
+    };
+    explicit FileFilterToken( Types t = End, const QString &s = QString(), bool n = false ) : type( t ), set( s ), negated( n ) {}
+    bool matches( const QChar &ch ) const;
+    Types type;
+    QString set;
+    bool negated;
+};
+
+/**
+ * @brief The FileFilterState struct (state of the lazily built automaton, a set of glob positions)
+ */
+struct FileFilterState {
+    explicit FileFilterState( const QVector<int> &p = QVector<int>(), bool a = false ) : positions( p ), accepting( a ) {}
+    QVector<int> positions;
+    bool accepting;
+    QHash<QChar, int> next;
+};
+
+/**
+ * @brief The FileFilterNamespace namespace (automaton limits)
+ */
+namespace FileFilterNamespace {
+static const int MaximumStates = 4096;
+}
+
+/**
+ * @brief The FileFilterGlobs class compiled set of glob patterns
+ *
+ * NOTE: all globs are compiled into a single automaton (positions of all patterns are tracked at
+ *       once, no backtracking); deterministic states are built on demand while matching and
+ *       cached, so a name is matched in a single pass, O(name length) once its states exist;
+ *       the cache is dropped if it grows beyond MaximumStates
+ */
+class FileFilterGlobs {
+public:
+    FileFilterGlobs() {}
+    bool isEmpty() const { return this->tokens.isEmpty(); }
+    void compile( const QStringList &patterns );
+    bool matches( const QString &name ) const;
+
+private:
+    void closure( QVector<int> &positions ) const;
+    int state( QVector<int> positions ) const;
+    void reset() const;
+    QVector<FileFilterToken> tokens;
+    QVector<int> starts;
+    mutable QVector<FileFilterState> states;
+    mutable QHash<QVector<int>, int> stateIds;
+};
+
+/**
+ * @brief The FileFilter class filter rules compiled for matching
+ */
+class FileFilter {
+public:
+    FileFilter() : m_empty( true ), m_needsMeta( false ) {}
+    const FileFilterRules &rules() const { return this->m_rules; }
+    void setRules( const FileFilterRules &rules );
+    bool isEmpty() const { return this->m_empty; }
+    bool accepts( const QModelIndex &index ) const;
+    bool accepts( const QString &name, const FileMeta &meta ) const;
+    static QString fold( const QString &name );
+
+private:
+    FileFilterRules m_rules;
+    FileFilterGlobs includes;
+    FileFilterGlobs excludes;
+    bool m_empty;
+    bool m_needsMeta;
+};
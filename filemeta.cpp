@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDateTime>
+#include <QHash>
+#include "filemeta.h"
+
+/**
+ * @brief FileMeta::fromFileInfo builds metadata from (possibly cached) file info
+ * NOTE: only symlinks cost extra syscalls here (readlink and a stat of the target)
+ * @param info
+ * @return
+ */
+FileMeta FileMeta::fromFileInfo( const QFileInfo &info ) {
+    FileMeta meta;
+
+    if ( !info.exists())
+        return meta;
+
+    meta.filePath = info.absoluteFilePath();
+    meta.symLink = info.isSymLink();
+    meta.type = info.isDir() ? Directory : File;
+    meta.size = info.size();
+    meta.modified = info.lastModified().toMSecsSinceEpoch();
+    meta.root = info.isRoot();
+    meta.hidden = info.isHidden();
+
+    // file info has no device and inode, key on path and size instead (mtime is compared separately)
+    meta.inode = FileMeta::pathId( meta.filePath, meta.size );
+
+    // resolve link target
+    if ( meta.isSymLink()) {
+        const QFileInfo target( info.symLinkTarget());
+
+        meta.target = target.absoluteFilePath();
+        if ( target.isDir())
+            meta.type = Directory;
+
+        if ( target.isRoot())
+            meta.root = true;
+    }
+
+    return meta;
+}
+
+/**
+ * @brief FileMeta::pathId stand-in for an inode where the real one is not known
+ * @param filePath
+ * @param size
+ * @return
+ */
+quint64 FileMeta::pathId( const QString &filePath, qint64 size ) {
+    const QByteArray path( filePath.toUtf8());
+    return (( static_cast<quint64>( qHash( path, 1 )) << 32 ) | qHash( path )) ^ static_cast<quint64>( size );
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QFileInfo>
+#include <QMetaType>
+
+/**
+ * @brief The FileMetaNamespace namespace
+ */
+namespace FileMetaNamespace {
+static const int FileMetaRole = Qt::UserRole + 16;
+}
+
+/**
+ * @brief The FileMeta struct file metadata collected once by the source model and carried
+ * through the icon pipeline (avoids repeated stat calls on the same file)
+ */
+struct FileMeta {
+    enum Types {
+        NoType = -1,
+        File,
+        Directory
+    };
+
+    FileMeta() : type( NoType ), symLink( false ), root( false ), hidden( false ), size( 0 ), modified( 0 ), device( 0 ), inode( 0 ) {}
+    static FileMeta fromFileInfo( const QFileInfo &info );
+    static quint64 pathId( const QString &filePath, qint64 size );
+    bool isValid() const { return !this->filePath.isEmpty(); }
+    bool isDir() const { return this->type == Directory; }
+    bool isSymLink() const { return this->symLink; }
+    bool isRoot() const { return this->root; }
+    QString absolutePath() const { return this->isSymLink() ? this->target : this->filePath; }
+
+    QString filePath;
+    QString target;
+    Types type;
+    bool symLink;
+    bool root;
+    bool hidden;
+    qint64 size;
+    qint64 modified;
+    quint64 device; // 0 if inode is a path id
+    quint64 inode;
+};
+Q_DECLARE_METATYPE( FileMeta )
@@ -27,10 +27,12 @@
  * @brief DragDropListModel::supportedDropActions
  * @return
  */
-FileSystemModel::FileSystemModel( QObject *parent, const QString &path ) : QFileSystemModel( parent ) {
+FileSystemModel::FileSystemModel( QObject *parent, const QString &path ) : FileSystemModelBase( parent ) {
+    // hidden files are listed (views filter them), filter must be set before listing starts
+    this->setFilter( QDir::NoDotAndDotDot | QDir::System | QDir::NoDot | QDir::NoDotDot | QDir::AllEntries | QDir::Hidden );
+
     // set root path
     this->setRootPath( path );
-    this->setFilter( QDir::NoDotAndDotDot | QDir::System | QDir::NoDot | QDir::NoDotDot | QDir::AllEntries );
 }
 
 /**
@@ -52,3 +54,23 @@ Qt::ItemFlags FileSystemModel::flags( const QModelIndex &index ) const {
 Qt::DropActions FileSystemModel::supportedDropActions() const {
     return Qt::CopyAction;
 }
+
+/**
+ * @brief FileSystemModel::data
+ * @param index
+ * @param role
+ * @return
+ */
+QVariant FileSystemModel::data( const QModelIndex &index, int role ) const {
+#ifndef Q_OS_LINUX
+    // file info is already cached by the model's gatherer, no need to stat again
+    if ( role == FileMetaNamespace::FileMetaRole ) {
+        if ( !index.isValid())
+            return QVariant();
+
+        return QVariant::fromValue( FileMeta::fromFileInfo( this->fileInfo( index )));
+    }
+#endif
+
+    return FileSystemModelBase::data( index, role );
+}
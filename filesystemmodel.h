@@ -22,18 +22,29 @@
 // includes
 //
 #include "proxymodel.h"
+#include "filemeta.h"
 #include <QFileSystemModel>
 #include <QFileSystemWatcher>
+#ifdef Q_OS_LINUX
+#include "directorymodel.h"
+#endif
 
 //
 // classes
 //
 class FolderView;
 
+// lightweight inotify based model on linux (no gatherer thread and watcher per view)
+#ifdef Q_OS_LINUX
+typedef DirectoryModel FileSystemModelBase;
+#else
+typedef QFileSystemModel FileSystemModelBase;
+#endif
+
 /**
  * @brief The FileSystemModel class
  */
-class FileSystemModel : public QFileSystemModel {
+class FileSystemModel : public FileSystemModelBase {
     Q_OBJECT
 
 public:
@@ -41,4 +52,5 @@ public:
     ~FileSystemModel() {}
     Qt::DropActions supportedDropActions() const;
     Qt::ItemFlags flags( const QModelIndex &index ) const;
+    QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const;
 };
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDebug>
+#include <QFile>
+#include "filewatcher.h"
+#include "main.h"
+#include <unistd.h>
+#include <sys/inotify.h>
+
+/**
+ * @brief FileWatcher::FileWatcher
+ * @param parent
+ */
+FileWatcher::FileWatcher( QObject *parent ) : QObject( parent ), m_inotify( -1 ), notifier( nullptr ), m_events( 0 ), m_interval( FileWatcherNamespace::MinimumInterval ) {
+    // announce
+#ifdef QT_DEBUG
+    qInfo() << this->tr( "initializing" );
+#endif
+
+    // add to garbage collector
+    GarbageMan::instance()->add( this );
+
+    // batches are delivered once per interval, not once per event
+    this->flushTimer.setSingleShot( true );
+    this->connect( &this->flushTimer, SIGNAL( timeout()), this, SLOT( flush()));
+
+    // changes are read on the GUI thread (events only carry names)
+    this->m_inotify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( this->m_inotify < 0 ) {
+        qWarning() << this->tr( "could not initialize inotify, directory changes will not be tracked" );
+        return;
+    }
+
+    this->notifier = new QSocketNotifier( this->m_inotify, QSocketNotifier::Read, this );
+    this->connect( this->notifier, SIGNAL( activated( int )), this, SLOT( readEvents()));
+}
+
+/**
+ * @brief FileWatcher::watch starts watching a directory (or adds a reference to an existing watch)
+ * @param path
+ */
+void FileWatcher::watch( const QString &path ) {
+    QHash<QString, FileWatcherEntry>::iterator entry( this->entries.find( path ));
+
+    if ( path.isEmpty())
+        return;
+
+    if ( entry == this->entries.end())
+        entry = this->entries.insert( path, FileWatcherEntry());
+
+    entry->references++;
+    this->addWatch( path );
+}
+
+/**
+ * @brief FileWatcher::addWatch adds an inotify watch for a directory that has none
+ * @param path
+ */
+void FileWatcher::addWatch( const QString &path ) {
+    const QHash<QString, FileWatcherEntry>::iterator entry( this->entries.find( path ));
+
+    if ( entry == this->entries.end() || entry->descriptor >= 0 || this->m_inotify < 0 )
+        return;
+
+    entry->descriptor = inotify_add_watch( this->m_inotify, QFile::encodeName( path ).constData(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR );
+
+    // different paths to the same directory share a descriptor
+    if ( entry->descriptor >= 0 && !this->descriptors[entry->descriptor].contains( path ))
+        this->descriptors[entry->descriptor] << path;
+}
+
+/**
+ * @brief FileWatcher::unwatch drops a reference, stops watching once no model uses the directory
+ * @param path
+ */
+void FileWatcher::unwatch( const QString &path ) {
+    const QHash<QString, FileWatcherEntry>::iterator entry( this->entries.find( path ));
+    int descriptor;
+
+    if ( entry == this->entries.end())
+        return;
+
+    entry->references--;
+    if ( entry->references > 0 )
+        return;
+
+    descriptor = entry->descriptor;
+    this->entries.erase( entry );
+    this->changes.remove( path );
+    this->rescans.remove( path );
+
+    if ( descriptor < 0 || !this->descriptors.contains( descriptor ))
+        return;
+
+    this->descriptors[descriptor].removeAll( path );
+    if ( this->descriptors[descriptor].isEmpty()) {
+        this->descriptors.remove( descriptor );
+        inotify_rm_watch( this->m_inotify, descriptor );
+    }
+}
+
+/**
+ * @brief FileWatcher::readEvents collects changed names per directory (delivered in flush)
+ */
+void FileWatcher::readEvents() {
+    alignas( struct inotify_event ) char buffer[FileWatcherNamespace::BufferSize];
+    ssize_t bytes, offset;
+
+    while (( bytes = read( this->m_inotify, buffer, sizeof( buffer ))) > 0 ) {
+        for ( offset = 0; offset < bytes; ) {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>( buffer + offset );
+
+            offset += static_cast<ssize_t>( sizeof( struct inotify_event ) + event->len );
+            this->m_events++;
+
+            // events were lost, list everything again
+            if ( event->mask & IN_Q_OVERFLOW ) {
+                const QList<QString> paths( this->entries.keys());
+
+                this->rescans.unite( QSet<QString>( paths.constBegin(), paths.constEnd()));
+                this->changes.clear();
+                continue;
+            }
+
+            // events of a removed watch
+            if ( !this->descriptors.contains( event->wd ))
+                continue;
+
+            // directory itself was removed or moved (watch is gone after IN_IGNORED)
+            if ( event->mask & ( IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED )) {
+                // a moved directory keeps its watch, which would report its changes under the old path
+                const bool drop = event->mask & ( IN_MOVE_SELF | IN_IGNORED );
+
+                foreach ( const QString &path, this->descriptors[event->wd] ) {
+                    this->rescans << path;
+                    this->changes.remove( path );
+
+                    if ( drop )
+                        this->entries[path].descriptor = -1;
+                }
+
+                if ( event->mask & IN_MOVE_SELF )
+                    inotify_rm_watch( this->m_inotify, event->wd );
+
+                if ( drop )
+                    this->descriptors.remove( event->wd );
+
+                continue;
+            }
+
+            if ( event->len == 0 )
+                continue;
+
+            foreach ( const QString &path, this->descriptors[event->wd] ) {
+                if ( this->rescans.contains( path ))
+                    continue;
+
+                QSet<QString> &names( this->changes[path] );
+                names << QFile::decodeName( event->name );
+
+                // listing the directory again is cheaper than stating each name
+                if ( names.count() > FileWatcherNamespace::MaximumNames ) {
+                    this->changes.remove( path );
+                    this->rescans << path;
+                }
+            }
+        }
+    }
+
+    this->schedule();
+}
+
+/**
+ * @brief FileWatcher::schedule starts the batch interval (does not restart it, so that a steady
+ * stream of events cannot postpone delivery forever)
+ */
+void FileWatcher::schedule() {
+    if (( this->changes.isEmpty() && this->rescans.isEmpty()) || this->flushTimer.isActive())
+        return;
+
+    this->flushTimer.start( this->m_interval );
+}
+
+/**
+ * @brief FileWatcher::flush delivers coalesced changes and adapts the batch interval to the event rate
+ */
+void FileWatcher::flush() {
+    const QHash<QString, QSet<QString> > changes( this->changes );
+    const QSet<QString> rescans( this->rescans );
+
+    // back off during bursts (e.g. builds or copies), recover once they are over
+    if ( this->m_events > FileWatcherNamespace::BurstEvents )
+        this->m_interval = qMin( this->m_interval * 2, FileWatcherNamespace::MaximumInterval );
+    else if ( this->m_events < FileWatcherNamespace::BurstEvents / 4 )
+        this->m_interval = qMax( this->m_interval / 2, FileWatcherNamespace::MinimumInterval );
+
+    this->m_events = 0;
+    this->changes.clear();
+    this->rescans.clear();
+
+    // receivers might watch or unwatch directories in between
+    foreach ( const QString &path, rescans ) {
+        // directory might have been created again
+        this->addWatch( path );
+        emit this->lost( path );
+    }
+
+    foreach ( const QString &path, changes.keys())
+        emit this->changed( path, changes[path] );
+}
+
+/**
+ * @brief FileWatcher::shutdown
+ */
+void FileWatcher::shutdown() {
+    this->flushTimer.stop();
+    this->changes.clear();
+    this->rescans.clear();
+    this->entries.clear();
+    this->descriptors.clear();
+
+    delete this->notifier;
+    this->notifier = nullptr;
+
+    if ( this->m_inotify >= 0 )
+        close( this->m_inotify );
+
+    this->m_inotify = -1;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+
+/**
+ * @brief The FileWatcherNamespace namespace
+ */
+namespace FileWatcherNamespace {
+static const int BufferSize = 32768;
+static const int MinimumInterval = 50;
+static const int MaximumInterval = 1000;
+static const int BurstEvents = 512;
+static const int MaximumNames = 4096;
+}
+
+/**
+ * @brief The FileWatcherEntry struct (watched directory and the number of models watching it)
+ */
+struct FileWatcherEntry {
+    explicit FileWatcherEntry( int d = -1 ) : descriptor( d ), references( 0 ) {}
+    int descriptor;
+    int references;
+};
+
+/**
+ * @brief The FileWatcher class process wide directory watcher (Linux only)
+ *
+ * NOTE: all directories share a single inotify descriptor; events are coalesced per directory
+ *       and delivered in batches (names of changed entries), the batch interval grows while
+ *       event rates are high and resets once the directory calms down
+ */
+class FileWatcher final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( FileWatcher )
+
+public:
+    static FileWatcher *instance() { static FileWatcher *instance( new FileWatcher()); return instance; }
+    ~FileWatcher() { this->shutdown(); }
+    void watch( const QString &path );
+    void unwatch( const QString &path );
+    int count() const { return this->entries.count(); }
+    int interval() const { return this->m_interval; }
+
+signals:
+    void changed( const QString &path, const QSet<QString> &names );
+    void lost( const QString &path );
+
+public slots:
+    void shutdown();
+
+private slots:
+    void readEvents();
+    void flush();
+
+private:
+    explicit FileWatcher( QObject *parent = nullptr );
+    void addWatch( const QString &path );
+    void schedule();
+    int m_inotify;
+    QSocketNotifier *notifier;
+    QHash<QString, FileWatcherEntry> entries;
+    QHash<int, QStringList> descriptors;
+    QHash<QString, QSet<QString> > changes;
+    QSet<QString> rescans;
+    QTimer flushTimer;
+    int m_events;
+    int m_interval;
+};
@@ -21,6 +21,7 @@
 //
 #include <QApplication>
 #include <QPainter>
+#include <QTextLayout>
 #include "folderdelegate.h"
 #include <QDebug>
 
@@ -31,6 +32,9 @@
 FolderDelegate::FolderDelegate( QListView *parent ) : m_textLineCount( FolderDelegateNamespace::TextLines ), m_selectionVisible( true ), m_topMargin( FolderDelegateNamespace::MarginTop ), m_sideMargin( FolderDelegateNamespace::MarginSide ), m_textMargin( FolderDelegateNamespace::MarginText ) {
     // set parent
     this->setParent( qobject_cast<QObject*>( parent ));
+
+    // least recently used layouts are dropped first
+    this->cache.setMaxCost( FolderDelegateNamespace::CachedLayouts );
 }
 
 /**
@@ -49,19 +53,10 @@ QSize FolderDelegate::sizeHint( const QStyleOptionViewItem &option, const QModel
     if ( view == nullptr )
         return QStyledItemDelegate::sizeHint( option, index );
 
-    // get display text
-    const QString text( view->model()->data( index, Qt::DisplayRole ).toString());
-
     // only icon mode has custom placement
     if ( view->viewMode() == QListView::IconMode ) {
         customOption.rect.setWidth( option.decorationSize.width() + this->sideMargin() * 2 );
-
-        if ( this->cache.contains( text )) {
-            item = this->cache[text];
-        } else {
-            item = this->textItemForIndex( customOption, index );
-            this->cache[text] = item;
-        }
+        item = this->textItemForIndex( customOption, index );
 
         size.setWidth( customOption.rect.width());
         size.setHeight( this->topMargin() + option.decorationSize.height() + item.lines.count() * item.textHeight );
@@ -71,49 +66,82 @@ QSize FolderDelegate::sizeHint( const QStyleOptionViewItem &option, const QModel
 }
 
 /**
- * @brief textItemForIndex
- * @param text
+ * @brief FolderDelegate::textItemForIndex returns (cached) text layout of an item
+ * @param option
+ * @param index
+ * @return
  */
 ListItem FolderDelegate::textItemForIndex( const QStyleOptionViewItem &option, const QModelIndex &index ) const {
-    QVector<QString> line( this->textLineCount());
-    int y, numLines = 0;
     QListView *view( qobject_cast<QListView*>( this->parent()));
-    ListItem item;
+    ListItem *cached;
 
     // get parent listView
     if ( view == nullptr )
+        return ListItem();
+
+    // look up the layout (this also marks it as recently used)
+    const ListItemKey key( view->model()->data( index, Qt::DisplayRole ).toString(), option.font, option.rect.width() - this->textMargin() * 2, this->textLineCount());
+    cached = this->cache.object( key );
+    if ( cached != nullptr )
+        return *cached;
+
+    const ListItem item( FolderDelegate::layoutText( key.text, key.font, key.width, key.lineCount ));
+    this->cache.insert( key, new ListItem( item ));
+    return item;
+}
+
+/**
+ * @brief FolderDelegate::layoutText breaks text into lines (at word boundaries if possible),
+ * the last line is elided if text does not fit
+ * @param text
+ * @param font
+ * @param width
+ * @param lineCount
+ * @return
+ */
+ListItem FolderDelegate::layoutText( const QString &text, const QFont &font, int width, int lineCount ) {
+    const QFontMetrics fontMetrics( font );
+    QTextLayout layout( text, font );
+    QTextOption textOption;
+    ListItem item;
+
+    if ( width <= 0 || lineCount <= 0 )
         return item;
 
-    // get display text and height
-    QString text( view->model()->data( index, Qt::DisplayRole ).toString());
-    const int textHeight = option.fontMetrics.height();
+    textOption.setWrapMode( QTextOption::WrapAtWordBoundaryOrAnywhere );
+    layout.setTextOption( textOption );
+    layout.beginLayout();
 
-    // split text into lines
-    while ( this->textLineCount() - numLines ) {
-        for ( y = 0; y < text.length(); y++ ) {
-            if ( option.fontMetrics.width( text.left( y + 1 )) > option.rect.width() - this->textMargin() * 2 )
-                break;
-        }
+    while ( item.lines.count() < lineCount ) {
+        QTextLine textLine( layout.createLine());
+        QString line;
 
-        if ( y > 0 ) {
-            if ( numLines < this->textLineCount() - 1 ) {
-                line[numLines] = text.left( y );
-                text = text.mid( y, text.length() - y );
-            } else
-                line[numLines] = option.fontMetrics.elidedText( text, Qt::ElideRight, option.rect.width() - this->textMargin() * 2 );
-        } else
+        if ( !textLine.isValid())
             break;
 
-        numLines++;
-    }
+        textLine.setLineWidth( width );
+
+        // last line gets the rest of the text
+        if ( item.lines.count() == lineCount - 1 )
+            line = fontMetrics.elidedText( text.mid( textLine.textStart()), Qt::ElideRight, width );
+        else
+            line = text.mid( textLine.textStart(), textLine.textLength());
+
+        // trailing spaces do not count when centering
+        while ( !line.isEmpty() && line.at( line.length() - 1 ).isSpace())
+            line.chop( 1 );
 
-    // store data as a new display item
-    for ( y = 0; y < numLines; y++ ) {
-        item.lines << line[y];
-        item.lineWidths << option.fontMetrics.width( line[y] ) + 1;
+        QStaticText staticText( line );
+        staticText.setTextFormat( Qt::PlainText );
+        staticText.prepare( QTransform(), font );
+
+        item.lines << staticText;
+        item.lineWidths << fontMetrics.width( line ) + 1;
     }
 
-    item.textHeight = textHeight;
+    layout.endLayout();
+    item.textHeight = fontMetrics.height();
+
     return item;
 }
 
@@ -142,9 +170,6 @@ void FolderDelegate::paint( QPainter *painter, const QStyleOptionViewItem &optio
         painter->fillRect( option.rect, hilightBrush );
     }
 
-    // get display text
-    const QString text( view->model()->data( index, Qt::DisplayRole ).toString());
-
     // restore painter state
     painter->restore();
 
@@ -152,8 +177,7 @@ void FolderDelegate::paint( QPainter *painter, const QStyleOptionViewItem &optio
     if ( view->viewMode() == QListView::IconMode ) {
         ListItem item;
         QRect rect;
-        int y;
-        QTextOption to;
+        int y, top;
 
         // get pixmap and its dimensions
         const QIcon icon( qvariant_cast<QIcon>( view->model()->data( index, Qt::DecorationRole )));
@@ -174,28 +198,12 @@ void FolderDelegate::paint( QPainter *painter, const QStyleOptionViewItem &optio
         painter->drawPixmap( rect, icon.pixmap( rect.size()));
 
         // split text into multiple lines
-        if ( cache.contains( text )) {
-            item = cache[text];
-        } else {
-            item = this->textItemForIndex( option, index );
-            cache[text] = item;
-        }
+        item = this->textItemForIndex( option, index );
 
-        //item = this->textItemForIndex( option, index );
-        to.setAlignment( Qt::AlignHCenter );
-
-        // init text rectangle
-        rect = option.rect;
-        rect.setY( this->topMargin() + rect.y() + height - item.textHeight );
-
-        // display multi-line text
-        for ( y = 0; y < item.lines.count(); y++ ) {
-            rect.setX( rect.x() + ( rect.width() - item.lineWidths.at( y )) / 2 );
-            rect.setY( rect.y() + item.textHeight );
-            rect.setHeight( item.textHeight );
-            rect.setWidth( item.lineWidths.at( y ));
-            painter->drawText( rect, item.lines.at( y ), to );
-        }
+        // display multi-line text (centered below the pixmap)
+        top = option.rect.y() + this->topMargin() + height;
+        for ( y = 0; y < item.lines.count(); y++ )
+            painter->drawStaticText( option.rect.x() + ( option.rect.width() - item.lineWidths.at( y )) / 2, top + y * item.textHeight, item.lines.at( y ));
     } else {
         QStyleOptionViewItem optionNoSelection( option );
         QStyle::State state;
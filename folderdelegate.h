@@ -24,18 +24,36 @@
 #include <QStyledItemDelegate>
 #include <QListView>
 #include <QHash>
+#include <QCache>
+#include <QFont>
+#include <QStaticText>
 
 /**
  * @brief The ListItem class
  */
 class ListItem {
 public:
-    QStringList lines;
+    ListItem() : textHeight( 0 ) {}
+    QVector<QStaticText> lines;
     QList<int> lineWidths;
     int textHeight;
 };
 Q_DECLARE_METATYPE( ListItem )
 
+/**
+ * @brief The ListItemKey struct identifies a text layout (same text might be laid out differently
+ * depending on font, available width and line count)
+ */
+struct ListItemKey {
+    explicit ListItemKey( const QString &t = QString(), const QFont &f = QFont(), int w = 0, int l = 0 ) : text( t ), font( f ), width( w ), lineCount( l ) {}
+    bool operator==( const ListItemKey &other ) const { return this->width == other.width && this->lineCount == other.lineCount && this->text == other.text && this->font == other.font; }
+    QString text;
+    QFont font;
+    int width;
+    int lineCount;
+};
+inline uint qHash( const ListItemKey &key, uint seed = 0 ) { return qHash( key.text, seed ) ^ qHash( key.font ) ^ qHash(( key.width << 8 ) | key.lineCount ); }
+
 /**
  * @brief The FolderDelegate class
  */
@@ -45,6 +63,7 @@ static const int MarginTop = 4;
 static const int MarginSide = 24;
 static const int TextLines = 3;
 static const int MarginText = 4;
+static const int CachedLayouts = 4096;
 }
 
 /**
@@ -60,9 +79,11 @@ public:
     ~FolderDelegate() {}
     int textLineCount() const { return this->m_textLineCount; }
     bool isSelectionVisible() const { return this->m_selectionVisible; }
-    int topMargin() const { return this->m_textLineCount; }
+    int topMargin() const { return this->m_topMargin; }
     int sideMargin() const { return this->m_sideMargin; }
     int textMargin() const { return this->m_textMargin; }
+    QSize cellSize( const QStyleOptionViewItem &option ) const { return QSize( option.decorationSize.width() + this->sideMargin() * 2, this->topMargin() + option.decorationSize.height() + this->textLineCount() * option.fontMetrics.height()); }
+    static ListItem layoutText( const QString &text, const QFont &font, int width, int lineCount );
 
 public slots:
     void clearCache() { this->cache.clear(); }
@@ -78,7 +99,7 @@ protected:
 
 private:
     ListItem textItemForIndex( const QStyleOptionViewItem &option, const QModelIndex &index ) const;
-    mutable QHash<QString, ListItem> cache;
+    mutable QCache<ListItemKey, ListItem> cache;
     int m_textLineCount;
     bool m_selectionVisible;
     int m_topMargin;
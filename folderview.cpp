@@ -26,6 +26,7 @@
 #include <QMenu>
 #include <QScreen>
 #include <QStorageInfo>
+#include <climits>
 #include "folderview.h"
 #include "folderdelegate.h"
 #include "proxymodel.h"
@@ -38,6 +39,7 @@
 #include <QScrollBar>
 #include "filesystemmodel.h"
 #include "foldermanager.h"
+#include "modelregistry.h"
 
 #ifdef Q_OS_WIN
 #include <shlobj.h>
@@ -50,7 +52,7 @@
  */
 FolderView::FolderView( QWidget *parent, const QString &rootPath, Modes mode ) :
     QWidget( parent ),
-    ui( new Ui::FolderView ), gesture( NoGesture ), currentGrabArea( NoArea ), m_sortOrder( Qt::AscendingOrder ), m_dirsFirst( true ), m_caseSensitive( false ), m_mode( mode ), preview( nullptr ) {
+    ui( new Ui::FolderView ), gesture( NoGesture ), currentGrabArea( NoArea ), m_rootPath( rootPath ), m_sortOrder( Qt::AscendingOrder ), m_dirsFirst( true ), m_caseSensitive( false ), m_numericSort( false ), m_readOnly( true ), m_mode( mode ), preview( nullptr ) {
     const QDir dir( rootPath );
     QFile styleSheet;
 
@@ -60,10 +62,18 @@ FolderView::FolderView( QWidget *parent, const QString &rootPath, Modes mode ) :
     // set icon mode by default
     this->ui->view->setViewMode( QListView::IconMode );
 
-    // set up listView and its model
-    this->model = new FileSystemModel( this, rootPath );
+    // set up listView and its model (source model is shared with views of the same directory)
+    this->model = ModelRegistry::instance()->acquire( rootPath );
     this->proxyModel = new ProxyModel( this );
     this->ui->view->setModel( this->proxyModel );
+    this->connect( this->ui->view, SIGNAL( visibleRangeChanged( int, int )), this->proxyModel, SLOT( setVisibleRange( int, int )));
+
+    // views are read only until configured otherwise
+    this->setReadOnly( this->m_readOnly );
+
+    // typing in the view filters it (search field is only shown while filtering)
+    this->ui->search->hide();
+    this->ui->search->installEventFilter( this );
 
     // set up view delegate
     this->delegate = new FolderDelegate( this->ui->view );
@@ -91,7 +101,12 @@ FolderView::FolderView( QWidget *parent, const QString &rootPath, Modes mode ) :
 
         styleSheet.setFileName( ":/styleSheets/preview.qss" );
     } else if ( this->mode() == Folder ) {
+        // all icons share one cell size, layout does not depend on the number of items
+        // (icon mode only, previews keep QListView's layout)
+        this->ui->view->setFixedGrid( true );
+
         styleSheet.setFileName( ":/styleSheets/dark.qss" );
+        this->connect( this->ui->view, SIGNAL( searchRequested( QString )), this, SLOT( startSearch( QString )));
     }
 
     // set default styleSheet
@@ -144,7 +159,7 @@ void FolderView::setupPreviewMode( int rows, int columns ) {
  * @brief FolderView::displaySymlinkLabelsChanged
  */
 void FolderView::displaySymlinkLabelsChanged() {
-    this->proxyModel->clearCache();
+    this->proxyModel->invalidateSymlinkIcons();
 }
 
 /**
@@ -153,16 +168,17 @@ void FolderView::displaySymlinkLabelsChanged() {
 FolderView::~FolderView() {
     delete this->proxyModel;
     delete this->delegate;
-    delete this->model;
+    ModelRegistry::instance()->release( this->model );
     delete this->preview;
     delete this->ui;
 }
 
 /**
- * @brief FolderView::rootPath
+ * @brief FolderView::sourceRootPath returns root of the shared source model (canonical path,
+ * unlike rootPath which is the path as configured)
  * @return
  */
-QString FolderView::rootPath() const {
+QString FolderView::sourceRootPath() const {
     return this->model->rootPath();
 }
 
@@ -192,10 +208,20 @@ int FolderView::iconSize() const {
  * @param path
  */
 void FolderView::setRootDirectory( const QString &path ) {
-    // NOTE: seems this does not crash app
-    //this->proxyModel->waitForThreads();
-    this->ui->view->setRootIndex( this->proxyModel->mapFromSource( this->model->setRootPath( path )));
+    FileSystemModel *previous = this->model;
+
+    // drop icon requests for the old root (does not block)
+    this->proxyModel->cancel();
+
+    // search results do not carry over to another directory
+    if ( !this->ui->search->text().isEmpty())
+        this->stopSearch();
+
+    // switch to the shared model of the new directory
+    this->m_rootPath = path;
+    this->model = ModelRegistry::instance()->acquire( path );
     this->sort();
+    ModelRegistry::instance()->release( previous );
 }
 
 /**
@@ -314,7 +340,7 @@ void FolderView::displayContextMenu( const QPoint &point ) {
         //
         {
             QMenu *sortMenu;
-            QAction *actionSortOrder, *actionDirsFirst, *actionCaseSensitive;
+            QAction *actionSortOrder, *actionDirsFirst, *actionCaseSensitive, *actionNumericSort;
 
             // sort menu
             sortMenu = menu.addMenu( IconCache::instance()->icon( "format-list-ordered", ":/icons/sort", 16 ), this->tr( "Sort" ));
@@ -325,7 +351,6 @@ void FolderView::displayContextMenu( const QPoint &point ) {
             actionSortOrder->setChecked( this->sortOrder() == Qt::AscendingOrder );
             actionSortOrder->setIcon( this->sortOrder() == Qt::AscendingOrder ? IconCache::instance()->icon( "view-sort-ascending", ":/icons/ascending", 16 ) : IconCache::instance()->icon( "view-sort-descending", ":/icons/descending", 16 ));
             this->connect( actionSortOrder, &QAction::triggered, [ this, actionSortOrder ]() {
-                this->proxyModel->waitForThreads();
                 this->setSortOrder( this->sortOrder() == Qt::AscendingOrder ? Qt::DescendingOrder : Qt::AscendingOrder );
                 actionSortOrder->setIcon( this->sortOrder() == Qt::AscendingOrder ? IconCache::instance()->icon( "view-sort-ascending", ":/icons/ascending", 16 ) : IconCache::instance()->icon( "view-sort-descending", ":/icons/descending", 16 ));
                 this->sort();
@@ -336,7 +361,6 @@ void FolderView::displayContextMenu( const QPoint &point ) {
             actionDirsFirst->setCheckable( true );
             actionDirsFirst->setChecked( this->directoriesFirst());
             this->connect( actionDirsFirst, &QAction::triggered, [this]() {
-                this->proxyModel->waitForThreads();
                 this->setDirectoriesFirst( !this->directoriesFirst());
                 this->sort();
             } );
@@ -345,10 +369,18 @@ void FolderView::displayContextMenu( const QPoint &point ) {
             actionCaseSensitive = sortMenu->addAction( QIcon( ":/icons/rename" ), this->tr( "Case sensitive" ));
             actionCaseSensitive->setCheckable( true );
             this->connect( actionCaseSensitive, &QAction::triggered, [this]() {
-                this->proxyModel->waitForThreads();
                 this->setCaseSensitive( !this->isCaseSensitive());
                 this->sort();
             } );
+
+            // natural (numeric) sort
+            actionNumericSort = sortMenu->addAction( this->tr( "Natural order" ));
+            actionNumericSort->setCheckable( true );
+            actionNumericSort->setChecked( this->isNumericSort());
+            this->connect( actionNumericSort, &QAction::triggered, [this]() {
+                this->setNumericSort( !this->isNumericSort());
+                this->sort();
+            } );
         }
 
         // add separator
@@ -362,6 +394,71 @@ void FolderView::displayContextMenu( const QPoint &point ) {
             this->setReadOnly( !this->isReadOnly());
         } );
 
+        //
+        // begin FILTER menu
+        //
+        {
+            QMenu *filterMenu;
+            QAction *actionHidden;
+
+            // filter menu
+            filterMenu = menu.addMenu( IconCache::instance()->icon( "view-filter", ":/icons/sort", 16 ), this->tr( "Filter" ));
+
+            // hidden files
+            actionHidden = filterMenu->addAction( this->tr( "Show hidden files" ));
+            actionHidden->setCheckable( true );
+            actionHidden->setChecked( this->filterRules().hidden );
+            this->connect( actionHidden, &QAction::triggered, [this]() {
+                FileFilterRules rules( this->filterRules());
+
+                rules.hidden = !rules.hidden;
+                this->setFilterRules( rules );
+            } );
+
+            // name patterns
+            this->connect( filterMenu->addAction( this->tr( "Set name patterns" )), &QAction::triggered, [this]() {
+                FileFilterRules rules( this->filterRules());
+                QString patterns;
+                bool ok;
+
+                patterns = QInputDialog::getText( this->parentWidget(), this->tr( "Set name patterns" ), this->tr( "Patterns (e.g. *.pdf; !*.tmp):" ), QLineEdit::Normal, rules.patterns(), &ok );
+                if ( ok ) {
+                    rules.setPatterns( patterns );
+                    this->setFilterRules( rules );
+                }
+            } );
+
+            // size limit
+            this->connect( filterMenu->addAction( this->tr( "Set size limit" )), &QAction::triggered, [this]() {
+                FileFilterRules rules( this->filterRules());
+                bool ok;
+
+                const int size = QInputDialog::getInt( this->parentWidget(), this->tr( "Set size limit" ), this->tr( "Maximum size in MB (0 for none):" ), static_cast<int>( rules.maximumSize / FileFilterNamespace::MegaByte ), 0, INT_MAX, 1, &ok );
+                if ( ok ) {
+                    rules.maximumSize = size * FileFilterNamespace::MegaByte;
+                    this->setFilterRules( rules );
+                }
+            } );
+
+            // age limit
+            this->connect( filterMenu->addAction( this->tr( "Set age limit" )), &QAction::triggered, [this]() {
+                FileFilterRules rules( this->filterRules());
+                bool ok;
+
+                const int days = QInputDialog::getInt( this->parentWidget(), this->tr( "Set age limit" ), this->tr( "Maximum age in days (0 for none):" ), rules.maximumAge, 0, INT_MAX, 1, &ok );
+                if ( ok ) {
+                    rules.maximumAge = days;
+                    this->setFilterRules( rules );
+                }
+            } );
+        }
+        // end FILTER menu
+
+        // item limit (for huge directories)
+        menu.addAction( this->tr( "Set item limit" ), this, SLOT( setMaxItems()));
+        if ( this->proxyModel->hasMoreItems())
+            menu.addAction( this->tr( "Show more items" ), this->proxyModel, SLOT( showMoreItems()));
+
 #ifdef QT_DEBUG
         menu.addSeparator();
         this->connect( menu.addAction( IconCache::instance()->icon( "application-exit", ":/icons/close", 16 ), this->tr( "Exit" )), &QAction::triggered, []() {
@@ -431,12 +528,55 @@ void FolderView::setIconSize() {
     const int size = QInputDialog::getInt( this->parentWidget(), this->tr( "Set icon size" ), this->tr( "Size:" ), this->iconSize(), 16, 256, 16, &ok );
     if ( ok ) {
         this->setIconSize( size );
-        this->proxyModel->clearCache();
+        this->proxyModel->invalidateIcons();
         this->delegate->clearCache();
         this->ui->view->setSpacing( this->ui->view->spacing());
     }
 }
 
+/**
+ * @brief FolderView::maxItems
+ * @return
+ */
+int FolderView::maxItems() const {
+    return this->proxyModel->maxItems();
+}
+
+/**
+ * @brief FolderView::setMaxItems
+ * @param count maximum number of entries shown (0 shows all)
+ */
+void FolderView::setMaxItems( int count ) {
+    this->proxyModel->setMaxItems( count );
+}
+
+/**
+ * @brief FolderView::filterRules
+ * @return
+ */
+FileFilterRules FolderView::filterRules() const {
+    return this->proxyModel->filterRules();
+}
+
+/**
+ * @brief FolderView::setFilterRules
+ * @param rules
+ */
+void FolderView::setFilterRules( const FileFilterRules &rules ) {
+    this->proxyModel->setFilterRules( rules );
+}
+
+/**
+ * @brief FolderView::setMaxItems
+ */
+void FolderView::setMaxItems() {
+    bool ok;
+
+    const int count = QInputDialog::getInt( this->parentWidget(), this->tr( "Set item limit" ), this->tr( "Items (0 shows all):" ), this->maxItems(), 0, INT_MAX, ProxyModelNamespace::MoreItems, &ok );
+    if ( ok )
+        this->setMaxItems( count );
+}
+
 /**
  * @brief FolderView::makeThumbnail
  */
@@ -456,7 +596,11 @@ void FolderView::makeThumbnail() {
         painter.drawRoundedRect( QRect( 1, 1, 46, 46 ), 4, 4 );
 
 #ifdef ALT_ICON
-        icon = IconCache::instance()->iconForFilename( this->rootPath(), 32 );
+        QIcon icon( IconCache::instance()->iconForFilename( this->rootPath(), 32 ));
+
+        // folder icon might be loading elsewhere, use the generic one
+        if ( icon.isNull())
+            icon = IconCache::instance()->icon( "inode-folder", ":/icons/folder", 32 );
 
         // draw folder icon
         if ( !icon.isNull()) {
@@ -483,7 +627,8 @@ void FolderView::makeThumbnail() {
  * @brief FolderView::setReadOnly
  */
 void FolderView::setReadOnly( bool enable ) {
-    this->model->setReadOnly( enable );
+    // source model is shared, so only the view refuses drops
+    this->m_readOnly = enable;
     this->ui->view->setReadOnly( enable );
 }
 
@@ -492,19 +637,51 @@ void FolderView::setReadOnly( bool enable ) {
  * @param order
  */
 void FolderView::sort() {
-    this->proxyModel->sort( 0 );
+    // attach source model once, later sort option changes re-sort the existing mapping in place
+    if ( this->proxyModel->sourceModel() != this->model ) {
+        this->proxyModel->sort( 0 );
+        this->proxyModel->setSourceModel( this->model );
+    } else {
+        this->proxyModel->resort();
+    }
 
-    // reset model
-    this->proxyModel->setSourceModel( this->model );
-    this->ui->view->setRootIndex( this->proxyModel->mapFromSource( this->model->setRootPath( this->rootPath())));
+    const QModelIndex rootIndex( this->proxyModel->mapFromSource( this->model->setRootPath( this->sourceRootPath())));
+    if ( this->ui->view->rootIndex() != rootIndex )
+        this->ui->view->setRootIndex( rootIndex );
 }
 
 /**
- * @brief FolderView::isReadOnly
- * @return
+ * @brief FolderView::startSearch shows the search field with the text typed in the view
+ * @param text
+ */
+void FolderView::startSearch( const QString &text ) {
+    if ( text.isEmpty() || !text.at( 0 ).isPrint())
+        return;
+
+    this->ui->search->show();
+    this->ui->search->setFocus();
+    this->ui->search->setText( this->ui->search->text() + text );
+}
+
+/**
+ * @brief FolderView::stopSearch clears the filter and hides the search field
  */
-bool FolderView::isReadOnly() const {
-    return this->model->isReadOnly();
+void FolderView::stopSearch() {
+    this->ui->search->clear();
+    this->ui->search->hide();
+    this->ui->view->setFocus();
+}
+
+/**
+ * @brief FolderView::on_search_textChanged
+ * @param text
+ */
+void FolderView::on_search_textChanged( const QString &text ) {
+    this->proxyModel->setSearchText( text );
+
+    // cleared (e.g. with the clear button)
+    if ( text.isEmpty() && this->ui->search->isVisible() && !this->ui->search->hasFocus())
+        this->stopSearch();
 }
 
 /**
@@ -555,6 +732,23 @@ bool FolderView::eventFilter( QObject *object, QEvent *event ) {
     QMouseEvent *mouseEvent;
     int y;
 
+    // search field keys
+    if ( object == this->ui->search && event->type() == QEvent::KeyPress ) {
+        const QKeyEvent *keyEvent( static_cast<QKeyEvent*>( event ));
+
+        if ( keyEvent->key() == Qt::Key_Escape ) {
+            this->stopSearch();
+            return true;
+        }
+
+        if ( keyEvent->key() == Qt::Key_Down || keyEvent->key() == Qt::Key_Return || keyEvent->key() == Qt::Key_Enter ) {
+            this->ui->view->setFocus();
+            return true;
+        }
+
+        return false;
+    }
+
     // TODO: use this instead of the hook in desktop widget?
     if ( event->type() == QEvent::ActivationChange && this->mode() == Preview ) {
         if ( QApplication::activeWindow() != this ) {
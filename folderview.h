@@ -27,6 +27,7 @@
 #include <windows.h>
 #endif
 #include "ui_folderview.h"
+#include "filefilter.h"
 
 //
 // classes
@@ -69,6 +70,8 @@ class FolderView : public QWidget {
     Q_PROPERTY( Qt::SortOrder sortOrder READ sortOrder WRITE setSortOrder )
     Q_PROPERTY( bool directoriesFirst READ directoriesFirst WRITE setDirectoriesFirst )
     Q_PROPERTY( bool caseSensitive READ isCaseSensitive WRITE setCaseSensitive )
+    Q_PROPERTY( bool numericSort READ isNumericSort WRITE setNumericSort )
+    Q_PROPERTY( int maxItems READ maxItems WRITE setMaxItems )
     Q_PROPERTY( QListView::ViewMode viewMode READ viewMode WRITE setViewMode )
     Q_PROPERTY( Modes mode READ mode WRITE setMode )
 
@@ -86,16 +89,20 @@ public:
 
     // properties
     QString title() const { if ( !this->customTitle().isNull()) return this->customTitle(); return this->ui->title->text(); }
-    QString rootPath() const;
+    QString rootPath() const { return this->m_rootPath; }
+    QString sourceRootPath() const;
     QString currentStyleSheet() const;
     QString customTitle() const { return this->m_customTitle; }
     QString customStyleSheet() const { return this->m_customStyleSheet; }
     QString defaultStyleSheet() const { return this->m_defaultStyleSheet; }
     int iconSize() const;
-    bool isReadOnly() const;
+    bool isReadOnly() const { return this->m_readOnly; }
     Qt::SortOrder sortOrder() const { return this->m_sortOrder; }
     bool directoriesFirst() const { return this->m_dirsFirst; }
     bool isCaseSensitive() const { return this->m_caseSensitive; }
+    bool isNumericSort() const { return this->m_numericSort; }
+    int maxItems() const;
+    FileFilterRules filterRules() const;
     QListView::ViewMode viewMode() const { return this->ui->view->viewMode(); }
     Modes mode() const { return this->m_mode; }
 
@@ -140,6 +147,9 @@ public slots:
     void setSortOrder( Qt::SortOrder order = Qt::AscendingOrder ) { this->m_sortOrder = order; }
     void setDirectoriesFirst( bool enable = true ) { this->m_dirsFirst = enable; }
     void setCaseSensitive( bool enable = false ) { this->m_caseSensitive = enable; }
+    void setNumericSort( bool enable = false ) { this->m_numericSort = enable; }
+    void setMaxItems( int count );
+    void setFilterRules( const FileFilterRules &rules );
     void setViewMode( QListView::ViewMode viewMode ) { this->ui->view->setViewMode( viewMode ); }
     void setMode( Modes mode ) { this->m_mode = mode; }
     void setupPreviewMode( int rows = 3, int columns = 3 );
@@ -149,6 +159,7 @@ public slots:
     void displayContextMenu( const QPoint &point );
     void resetStyleSheet();
     void setIconSize();
+    void setMaxItems();
     void makeThumbnail();
     void setRootDirectory( const QString &path );
     void createPreviewWidget( const QString &path );
@@ -164,6 +175,9 @@ private slots:
     void on_view_clicked( const QModelIndex &index );
     void on_view_customContextMenuRequested( const QPoint &pos );
     void displaySymlinkLabelsChanged();
+    void on_search_textChanged( const QString &text );
+    void startSearch( const QString &text );
+    void stopSearch();
 
 private:
     Ui::FolderView *ui;
@@ -180,12 +194,15 @@ private:
     QRect grabAreas[Frame::MouseGrabAreas];
 
     // properties
+    QString m_rootPath;
     QString m_customTitle;
     QString m_customStyleSheet;
     QString m_defaultStyleSheet;
     Qt::SortOrder m_sortOrder;
     bool m_dirsFirst;
     bool m_caseSensitive;
+    bool m_numericSort;
+    bool m_readOnly;
     Modes m_mode;
 
     // preview
@@ -22,9 +22,11 @@
 #include "iconcache.h"
 #include "iconindex.h"
 #include "indexcache.h"
+#include "imagescaler.h"
+#include "mimecache.h"
 #include "variable.h"
 #include <QPainter>
-#include <QMimeDatabase>
+#include <QImageReader>
 #include <QDebug>
 #ifdef Q_OS_WIN
 #include <QtWin>
@@ -40,12 +42,15 @@
  * @brief IconCache::IconCache
  * @param parent
  */
-IconCache::IconCache( QObject *parent ) : QObject( parent ) {
+IconCache::IconCache( QObject *parent ) : QObject( parent ), m_symlinkLabels( Variable::instance()->isEnabled( "ui_displaySymlinkIcon" )) {
     // announce
 #ifdef QT_DEBUG
     qInfo() << this->tr( "initializing" );
 #endif
 
+    // track symlink label setting (workers must not look it up by name)
+    this->connect( Variable::instance(), SIGNAL( valueChanged( QString )), this, SLOT( variableChanged( QString )));
+
     // add to garbage collector
     GarbageMan::instance()->add( this );
 }
@@ -113,20 +118,195 @@ QIcon IconCache::icon( const QString &iconName, int scale, const QString theme,
 }
 
 /**
- * @brief IconCache::fastDownscale
- * @param pixmap
+ * @brief IconCache::image thread-safe counterpart of IconCache::icon
+ * @param iconName
+ * @param scale
+ * @param theme
+ * @param fallback
  * @return
  */
-QPixmap IconCache::fastDownscale( const QPixmap &pixmap, int scale ) const {
-    QPixmap downScaled( pixmap );
+QImage IconCache::image( const QString &iconName, int scale, const QString theme, const QString &fallback ) {
+    QImage image;
+    QString themeName( theme );
+
+    // revert to default if empty
+    if ( themeName.isEmpty())
+        themeName = IconIndex::instance()->defaultTheme();
+
+    // return empty image on invalid themes
+    if ( !QString::compare( themeName, "system" ))
+        return QImage();
 
-    if ( pixmap.isNull() || scale <= 0 )
-        return QPixmap();
+    // make unique images for different sizes
+    const QString alias( QString( "%1_%2_%3" ).arg( iconName ).arg( themeName ).arg( scale ));
+
+    // retrieve image from internal cache
+    {
+        QMutexLocker lock( &this->mutex );
+        if ( this->images.contains( alias ))
+            return this->images[alias];
+    }
+
+    // NOTE: theme icons are not coalesced, a read is cheap and cached afterwards; reading the
+    //       same icon twice on a race is preferred over making a thread wait for another one
+
+    // read image from the file in index cache
+    image = this->readImage( IndexCache::instance()->fileName( iconName, scale, themeName ), scale );
 
-    if ( downScaled.width() >= scale * 2.0f )
-        downScaled = downScaled.scaled( static_cast<int>( scale * 2.0f ), static_cast<int>( scale * 2.0f ), Qt::IgnoreAspectRatio, Qt::FastTransformation );
+    // handle missing icons
+    if ( image.isNull()) {
+        /* here we read fallback icons from either cache or actual files */
+        const QString cachedName( IndexCache::instance()->path() + "/" + alias + ".png" );
 
-    return downScaled.scaled( scale, scale, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+        // first check cache, then try the actual file
+        image.load( cachedName );
+        if ( image.isNull() && !fallback.isEmpty()) {
+            image = this->readImage( fallback, scale );
+
+            // write out icons with known sizes
+            if ( !image.isNull() && scale > 0 )
+                image.save( cachedName );
+        }
+
+        if ( image.isNull()) {
+            image = this->readImage( IndexCache::instance()->fileName( "application-x-zerosize", scale, themeName ), scale );
+            if ( image.isNull())
+                return QImage();
+        }
+    }
+
+    // add image to cache
+    image = image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+    this->add( alias, image );
+
+    return image;
+}
+
+/**
+ * @brief IconCache::coalesce runs function once per key, concurrent callers with the same key
+ * attach their callbacks to the in-flight computation and return immediately
+ * (callbacks are run by the thread that computes the image)
+ * @param key
+ * @param cancelled caller's cancellation token
+ * @param callback receives the image
+ * @param function gets a token that is cancelled once all callers have cancelled
+ */
+void IconCache::coalesce( const QString &key, const IconCancelled &cancelled, const IconCallback &callback, const std::function<QImage( const IconCancelled & )> &function ) {
+    QSharedPointer<IconFlight> flight;
+    QList<IconCallback> callbacks;
+    QImage image;
+    bool aborted = false;
+
+    this->m_requests.ref();
+
+    // join an in-flight request if there is one
+    {
+        QMutexLocker lock( &this->flightMutex );
+
+        if ( this->flights.contains( key )) {
+            flight = this->flights[key];
+            flight->tokens << cancelled;
+            flight->callbacks << callback;
+            this->m_coalesced.ref();
+            return;
+        }
+
+        flight = QSharedPointer<IconFlight>( new IconFlight());
+        flight->tokens << cancelled;
+        flight->callbacks << callback;
+        this->flights[key] = flight;
+    }
+
+    // the load is abandoned only if nobody wants the result anymore
+    const IconCancelled flightCancelled( [ this, flight, &aborted ]() {
+        QMutexLocker lock( &this->flightMutex );
+
+        if ( IconCache::isCancelled( *flight ))
+            aborted = true;
+
+        return aborted;
+    } );
+
+    // compute and publish the result
+    forever {
+        image = function( flightCancelled );
+
+        QMutexLocker lock( &this->flightMutex );
+
+        // a caller joined after the load was abandoned, start over
+        if ( aborted && !IconCache::isCancelled( *flight )) {
+            aborted = false;
+            continue;
+        }
+
+        callbacks = flight->callbacks;
+        this->flights.remove( key );
+        break;
+    }
+
+    // late joiners cannot attach anymore, hand out the result outside the lock
+    foreach ( const IconCallback &receiver, callbacks )
+        receiver( image );
+}
+
+/**
+ * @brief IconCache::isCancelled returns true if all callers of a flight have cancelled
+ * (flight mutex must be held)
+ * @param flight
+ * @return
+ */
+bool IconCache::isCancelled( const IconFlight &flight ) {
+    foreach ( const IconCancelled &token, flight.tokens ) {
+        if ( !token || !token())
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief IconCache::readImage reads an image file, rendering scalable images directly at the
+ * requested size and downscaling larger bitmaps
+ * @param fileName
+ * @param scale
+ * @return
+ */
+QImage IconCache::readImage( const QString &fileName, int scale ) const {
+    QImage image;
+
+    if ( fileName.isEmpty())
+        return image;
+
+    QImageReader reader( fileName );
+    const QSize size( reader.size());
+
+    // let vector formats render at target size
+    if ( scale > 0 && size.isValid() && reader.supportsOption( QImageIOHandler::ScaledSize ))
+        reader.setScaledSize( size.scaled( scale, scale, Qt::KeepAspectRatio ));
+
+    if ( !reader.read( &image ))
+        return QImage();
+
+    // never upscale, just downscale oversized bitmaps
+    if ( scale > 0 && ( image.width() > scale || image.height() > scale )) {
+        const QSize scaled( image.size().scaled( scale, scale, Qt::KeepAspectRatio ));
+        image = ImageScaler::downscale( image, scaled.width(), scaled.height());
+    }
+
+    return image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+}
+
+/**
+ * @brief IconCache::fastDownscale
+ * @param image
+ * @param scale
+ * @return
+ */
+QImage IconCache::fastDownscale( const QImage &image, int scale ) const {
+    if ( image.isNull() || scale <= 0 )
+        return QImage();
+
+    return ImageScaler::downscale( image, scale );
 }
 
 /**
@@ -135,53 +315,62 @@ QPixmap IconCache::fastDownscale( const QPixmap &pixmap, int scale ) const {
  * @param scale
  * @return
  */
-QIcon IconCache::thumbnail( const QString &fileName, int scale, bool upscale ) {
+QImage IconCache::thumbnail( const QString &fileName, int scale, bool upscale, const IconCancelled &cancelled ) {
     QRect rect;
-    QIcon icon;
-    QPixmap pixmap, cache;
+    QImage image, cache;
 
     // thumbnail cache
     QString cachedFile( this->fileNameForHash( hashForFile( fileName ), scale ));
     if ( !cachedFile.isEmpty()) {
         if ( cache.load( cachedFile ))
-            return QIcon( cache );
+            return cache.convertToFormat( QImage::Format_ARGB32_Premultiplied );
     }
 
-    if ( !pixmap.load( fileName ))
-        return icon;
+    // cancelled after hashing
+    if ( cancelled && cancelled())
+        return QImage();
+
+    if ( !image.load( fileName ))
+        return QImage();
 
-    if ( pixmap.isNull() && !pixmap.width())
-        return icon;
+    // cancelled after decoding
+    if ( cancelled && cancelled())
+        return QImage();
 
-    if ( upscale && pixmap.width() < scale )
-        pixmap = pixmap.scaledToWidth( scale, Qt::SmoothTransformation );
+    if ( image.isNull() && !image.width())
+        return QImage();
 
-    if ( pixmap.height() < scale || pixmap.width() < scale ) {
-        QPixmap result( scale, scale );
+    if ( upscale && image.width() < scale )
+        image = image.scaledToWidth( scale, Qt::SmoothTransformation );
+
+    if ( image.height() < scale || image.width() < scale ) {
+        QImage result( scale, scale, QImage::Format_ARGB32_Premultiplied );
         result.fill( Qt::transparent );
         {
             QPainter painter( &result );
-            painter.drawPixmap( scale / 2 - pixmap.width() / 2, scale / 2 - pixmap.height() / 2, pixmap );
+            painter.drawImage( scale / 2 - image.width() / 2, scale / 2 - image.height() / 2, image );
         }
-        pixmap = result;
-    } else if ( pixmap.height() > scale || pixmap.width() > scale ) {
-        if ( pixmap.width() > pixmap.height())
-            rect = QRect( pixmap.width() / 2 - pixmap.height() / 2, 0, pixmap.height(), pixmap.height());
-        else if ( pixmap.width() < pixmap.height())
-            rect = QRect( 0, pixmap.height() / 2 - pixmap.width() / 2, pixmap.width(), pixmap.width());
-
-        pixmap = pixmap.copy( rect );
-        pixmap = this->fastDownscale( pixmap, scale );
-    }
+        image = result;
+    } else if ( image.height() > scale || image.width() > scale ) {
+        if ( image.width() > image.height())
+            rect = QRect( image.width() / 2 - image.height() / 2, 0, image.height(), image.height());
+        else if ( image.width() < image.height())
+            rect = QRect( 0, image.height() / 2 - image.width() / 2, image.width(), image.width());
 
-    if ( !pixmap.isNull()) {
-        icon = QIcon( pixmap );
+        if ( rect.isValid())
+            image = image.copy( rect );
 
-        if ( !cachedFile.isEmpty())
-            pixmap.save( cachedFile );
+        image = this->fastDownscale( image, scale );
     }
 
-    return icon;
+    // cancelled after scaling (do not store anything)
+    if ( cancelled && cancelled())
+        return QImage();
+
+    if ( !image.isNull() && !cachedFile.isEmpty())
+        image.save( cachedFile );
+
+    return image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
 }
 
 /**
@@ -262,14 +451,13 @@ QString IconCache::fileNameForHash( quint32 hash, int scale ) const {
 #ifdef Q_OS_WIN
 
 /**
- * @brief IconCache::extractPixmap
+ * @brief IconCache::extractImage
  * @param fileName
  * @return
  */
-QPixmap IconCache::extractPixmap( const QString &fileName, int scale ) {
+QImage IconCache::extractImage( const QString &fileName, int scale ) {
     SHFILEINFO fileInfo;
-    QPixmap pixmap, cache;
-    QImage image;
+    QImage image, cache;
     QFileInfo info( fileName );
     int flags = SHGFI_ICON | SHGFI_SYSICONINDEX | SHGFI_LARGEICON;
     int y, k;
@@ -281,8 +469,7 @@ QPixmap IconCache::extractPixmap( const QString &fileName, int scale ) {
         flags |= SHGFI_USEFILEATTRIBUTES;
 
     // win32 icon cache
-    const QMimeDatabase db;
-    const QMimeType mime( db.mimeTypeForFile( fileName, QMimeDatabase::MatchContent ));
+    const QMimeType mime( MimeCache::instance()->mimeType( fileName ));
     const QString cachedFile(
                 !QString::compare( mime.iconName(), "application-x-ms-dos-executable" ) || info.isSymLink() ?
                     this->fileNameForHash( hashForFile( fileName ), scale ) :
@@ -291,7 +478,7 @@ QPixmap IconCache::extractPixmap( const QString &fileName, int scale ) {
 
     if ( !cachedFile.isEmpty()) {
         if ( cache.load( cachedFile ))
-            return cache;
+            return cache.convertToFormat( QImage::Format_ARGB32_Premultiplied );
     }
 
     const int hrFileInfo = static_cast<const int>( SHGetFileInfo( reinterpret_cast<const wchar_t *>( QDir::toNativeSeparators( fileName ).utf16()), 0, &fileInfo, sizeof( SHFILEINFO ), static_cast<UINT>( flags )));
@@ -304,13 +491,13 @@ QPixmap IconCache::extractPixmap( const QString &fileName, int scale ) {
 #endif
     {
         if ( QSysInfo::windowsVersion() >= QSysInfo::WV_VISTA && fileInfo.hIcon ) {
-            auto pixmapFromImageList = [ fileInfo ]( int index, QPixmap &pixmap ) {
+            auto imageFromImageList = [ fileInfo ]( int index, QImage &image ) {
                 IImageList *imageList = nullptr;
                 HICON hIcon = 0;
 
                 if ( static_cast<int>( SHGetImageList( index, IID_PPV_ARGS( &imageList ))) >= 0 ) {
                     if ( static_cast<int>( imageList->GetIcon( fileInfo.iIcon, ILD_TRANSPARENT, &hIcon )) >=0 ) {
-                        pixmap = QtWin::fromHICON( hIcon );
+                        image = QtWin::imageFromHICON( hIcon );
                         DestroyIcon( hIcon );
                         imageList->Release();
                     }
@@ -318,14 +505,13 @@ QPixmap IconCache::extractPixmap( const QString &fileName, int scale ) {
             };
 
             // first try to get the jumbo icon
-            pixmapFromImageList( 0x4, pixmap );
+            imageFromImageList( 0x4, image );
 
             // test if most of the image is blank
             // (invalid jumbo with 48x48 on top left)
-            if ( pixmap.width() >= 64 && pixmap.height() >= 64 ) {
-                image = pixmap.toImage();
-                for ( y = 64; y < pixmap.width(); y++ ) {
-                    for ( k = 64; k < pixmap.height(); k++ ) {
+            if ( image.width() >= 64 && image.height() >= 64 ) {
+                for ( y = 64; y < image.width(); y++ ) {
+                    for ( k = 64; k < image.height(); k++ ) {
                         if ( image.pixelColor( y, k ).alphaF() > 0.0 )
                             ok = true;
                     }
@@ -380,41 +566,55 @@ QPixmap IconCache::extractPixmap( const QString &fileName, int scale ) {
             }
 
             // then try to get the large icon
-            if ( pixmap.isNull() || !ok )
-                pixmapFromImageList( 0x2, pixmap );
+            if ( image.isNull() || !ok )
+                imageFromImageList( 0x2, image );
         }
 
         // if everything fails, get icon the old way
-        if ( pixmap.isNull() && fileInfo.hIcon ) {
-            pixmap = QtWin::fromHICON( fileInfo.hIcon );
+        if ( image.isNull() && fileInfo.hIcon ) {
+            image = QtWin::imageFromHICON( fileInfo.hIcon );
             DestroyIcon( fileInfo.hIcon );
         }
     }
 
     // save icon in cache folder as plain PNG for faster reads
-    pixmap = this->fastDownscale( pixmap, scale );
+    image = this->fastDownscale( image, scale );
     if ( !cachedFile.isEmpty())
-        pixmap.save( cachedFile );
+        image.save( cachedFile );
 
-    return pixmap;
+    return image;
+}
+
+/**
+ * @brief IconCache::linkOverlay returns the overlay arrow (rendered once per size)
+ * @param overlaySize
+ * @return
+ */
+QImage IconCache::linkOverlay( int overlaySize ) {
+    QMutexLocker lock( &this->mutex );
+
+    if ( !this->overlays.contains( overlaySize )) {
+        // get overlay arrow (TODO: allow custom arrows)
+        this->overlays[overlaySize] = this->readImage( IconCacheNamespace::LinkOverlay, overlaySize );
+    }
+
+    return this->overlays[overlaySize];
 }
-#endif
 
 /**
  * @brief IconCache::addSymlinkLabel
- * @param icon
+ * @param image
  * @param originalSize
+ * @param baseKey cache alias of the base image (composite is not cached if empty)
  * @return
  */
-QIcon IconCache::addSymlinkLabel( const QIcon &icon, int originalSize ) {
-    QPixmap base, overlay;
-    QIcon overlayIcon( ":/icons/link" );
+QImage IconCache::addSymlinkLabel( const QImage &image, int originalSize, const QString &baseKey ) {
     const float factor = 4.0f;
     int overlaySize = static_cast<int>( originalSize / factor );
 
     // abort if disabled
-    if ( Variable::instance()->isDisabled( "ui_displaySymlinkIcon" ))
-        return icon;
+    if ( !this->m_symlinkLabels.load() || image.isNull())
+        return image;
 
     // limit shortcut arrow size
     if ( overlaySize > 24 )
@@ -422,26 +622,59 @@ QIcon IconCache::addSymlinkLabel( const QIcon &icon, int originalSize ) {
     else if ( overlaySize < 8 )
         overlaySize = 8;
 
-    // get base pixmap (the icon)
-    base = icon.pixmap( originalSize, originalSize );
-    const QSize actualSize( icon.actualSize( QSize( originalSize, originalSize )));
+    // many links share the same base icon, reuse previous composites
+    const QString alias( baseKey.isEmpty() ? QString() : QString( "%1_%2_%3" ).arg( baseKey ).arg( originalSize ).arg( IconCacheNamespace::LinkOverlay ));
+    if ( !alias.isEmpty()) {
+        QMutexLocker lock( &this->mutex );
 
-    // get overlay arrow (TODO: allow custom arrows)
-    overlay = overlayIcon.pixmap( overlaySize, overlaySize );
+        if ( this->composites.contains( alias ))
+            return this->composites[alias];
+    }
 
-    // superimpose arrow over base pixmap
-    QPixmap result( originalSize, originalSize );
+    const QImage overlay( this->linkOverlay( overlaySize ));
+
+    // superimpose arrow over base image
+    QImage result( originalSize, originalSize, QImage::Format_ARGB32_Premultiplied );
     result.fill( Qt::transparent );
     {
         QPainter painter( &result );
-        painter.drawPixmap( originalSize / 2 - actualSize.width() / 2, originalSize / 2 - actualSize.height() / 2, base );
-        painter.drawPixmap( 0, originalSize - overlaySize, overlaySize, overlaySize, overlay );
+        painter.drawImage( originalSize / 2 - image.width() / 2, originalSize / 2 - image.height() / 2, image );
+        painter.drawImage( QRect( 0, originalSize - overlaySize, overlaySize, overlaySize ), overlay );
+    }
+
+    // store composite
+    if ( !alias.isEmpty()) {
+        QMutexLocker lock( &this->mutex );
+        this->composites[alias] = result;
     }
 
-    // return overlay icon
-    return QIcon( result );
+    // return overlay image
+    return result;
 }
+#endif
 
+/**
+ * @brief IconCache::shutdown
+ */
+void IconCache::shutdown() {
+    this->cache.clear();
+
+    QMutexLocker lock( &this->mutex );
+    this->images.clear();
+#ifdef Q_OS_WIN
+    this->overlays.clear();
+    this->composites.clear();
+#endif
+}
+
+/**
+ * @brief IconCache::variableChanged
+ * @param key
+ */
+void IconCache::variableChanged( const QString &key ) {
+    if ( !QString::compare( key, "ui_displaySymlinkIcon" ))
+        this->m_symlinkLabels.store( Variable::instance()->isEnabled( key ));
+}
 
 /**
  * @brief ProxyModel::getDriveIconName
@@ -477,75 +710,206 @@ QString IconCache::getDriveIconName( const QString &path ) const {
 #endif
 
 /**
- * @brief IconCache::iconForFilename
+ * @brief IconCache::imageForFilename
  * @return
  */
-QIcon IconCache::iconForFilename( const QString &fileName, int scale, bool upscale ) {
-    const QFileInfo info( fileName );
-    const QFileInfo target( info.symLinkTarget());
+QImage IconCache::imageForFilename( const QString &fileName, int scale, bool upscale ) {
+    return this->imageForFilename( FileMeta::fromFileInfo( QFileInfo( fileName )), scale, upscale );
+}
+
+/**
+ * @brief IconCache::imageForFilename loads the image on the calling thread, or returns a null
+ * image if the same file is being loaded elsewhere (imageReady() is emitted once it is done)
+ * @param meta
+ * @param scale
+ * @param upscale
+ * @return
+ */
+QImage IconCache::imageForFilename( const FileMeta &meta, int scale, bool upscale ) {
+    const QSharedPointer<QImage> result( new QImage());
+    const QSharedPointer<QAtomicInt> returned( new QAtomicInt( 0 ));
+    const QString fileName( meta.filePath );
+
+    // whichever comes first, the result or the return, decides how the image is delivered
+    this->requestImageForFilename( meta, scale, upscale, IconCancelled(), [ this, result, returned, fileName, scale ]( const QImage &image ) {
+        if ( returned->testAndSetOrdered( 0, 1 ))
+            *result = image;
+        else
+            emit this->imageReady( fileName, scale, image );
+    } );
+
+    if ( returned->testAndSetOrdered( 0, 1 ))
+        return QImage();
+
+    return *result;
+}
+
+/**
+ * @brief IconCache::requestImageForFilename loads the image on the calling thread, or attaches
+ * callback to the same file being loaded elsewhere (does not wait for it)
+ * @param meta
+ * @param scale
+ * @param upscale
+ * @param cancelled checked between stages of the load
+ * @param callback receives the image (also null images, so that requests can be marked as done)
+ */
+void IconCache::requestImageForFilename( const FileMeta &meta, int scale, bool upscale, const IconCancelled &cancelled, const IconCallback &callback ) {
+    if ( !meta.isValid()) {
+        callback( QImage());
+        return;
+    }
+
+    // views showing the same folder (and desktop icons) often ask for the same file at once
+    this->coalesce( QString( "file:%1_%2_%3" ).arg( meta.filePath ).arg( scale ).arg( upscale ), cancelled, callback, [ this, meta, scale, upscale ]( const IconCancelled &flightCancelled ) -> QImage {
+        return this->loadImageForFilename( meta, scale, upscale, flightCancelled );
+    } );
+}
+
+/**
+ * @brief IconCache::iconKey cheap identity of the icon a file resolves to: shared by all files of
+ * the same type, or per file revision if the icon depends on the file itself (e.g. thumbnails)
+ * or the type cannot be resolved without reading the file
+ * @param meta
+ * @param scale
+ * @return
+ */
+QString IconCache::iconKey( const FileMeta &meta, int scale ) const {
     QString iconName;
-    const QString absolutePath( info.isSymLink() ? target.absoluteFilePath() : info.absoluteFilePath());
-    const QMimeDatabase db;
-    QIcon icon;
-    const bool isDir = info.isDir() || target.isDir();
 
-    // get mimetype by matching content
-    iconName = isDir ? "inode-directory" : db.mimeTypeForFile( absolutePath, QMimeDatabase::MatchContent ).iconName();
+    if ( !meta.isValid())
+        return QString();
+
+#ifdef Q_OS_WIN
+    // drive icons, shortcuts and symlink labels are per file
+    if ( meta.isRoot() || meta.isSymLink() || meta.filePath.endsWith( ".appref-ms" ))
+        return this->fileKey( meta, scale );
+#endif
+
+    if ( meta.isDir()) {
+        iconName = "inode-directory";
+    } else {
+        const QMimeType mimeType( MimeCache::instance()->cachedMimeType( meta ));
+        if ( !mimeType.isValid())
+            return this->fileKey( meta, scale );
+
+        iconName = mimeType.iconName();
+
+        // thumbnails
+        if ( iconName.startsWith( "image-" ))
+            return this->fileKey( meta, scale );
+
+#ifdef Q_OS_WIN
+        // executables have their own icons
+        if ( iconName.startsWith( "application-x-ms-dos-executable" ))
+            return this->fileKey( meta, scale );
+#endif
+    }
+
+    return QString( "%1_%2_%3" ).arg( iconName ).arg( IconIndex::instance()->defaultTheme()).arg( scale );
+}
+
+/**
+ * @brief IconCache::fileKey identity of a per file icon (changes with the file and label setting)
+ * @param meta
+ * @param scale
+ * @return
+ */
+QString IconCache::fileKey( const FileMeta &meta, int scale ) const {
+#ifdef Q_OS_WIN
+    const bool labels = this->m_symlinkLabels.load() && ( meta.isSymLink() || meta.filePath.endsWith( ".appref-ms" ));
+#else
+    const bool labels = false;
+#endif
+
+    return QString( "file:%1_%2_%3_%4" ).arg( meta.filePath ).arg( meta.modified ).arg( scale ).arg( labels );
+}
+
+/**
+ * @brief IconCache::loadImageForFilename
+ * @param meta
+ * @param scale
+ * @param upscale
+ * @param cancelled checked between stages (mime sniffing, thumbnail hash/decode/scale/save, theme icon)
+ * @return
+ */
+QImage IconCache::loadImageForFilename( const FileMeta &meta, int scale, bool upscale, const IconCancelled &cancelled ) {
+    QString iconName;
+    const QString fileName( meta.filePath );
+    const QString absolutePath( meta.absolutePath());
+    QImage image;
+    const bool isDir = meta.isDir();
+
+    // get mimetype (glob first, content only if ambiguous)
+    iconName = isDir ? "inode-directory" : MimeCache::instance()->mimeType( meta ).iconName();
+    if ( cancelled && cancelled())
+        return image;
 
 #ifdef Q_OS_WIN
     // initialize COM (needed for SHGetFileInfo in a threaded environment)
     const int hrCoInit = static_cast<const int>( CoInitializeEx( NULL, COINIT_APARTMENTTHREADED ));
     if ( hrCoInit < 0 )
-        return icon;
+        return image;
 
-    if ( info.isRoot() || target.isRoot())
+    if ( meta.isRoot())
         iconName = IconCache::instance()->getDriveIconName( absolutePath );
+
+    // alias of the base image (for symlink label composites)
+    QString baseKey;
 #endif
 
     // generate thumbnail for images
     if ( !isDir ) {
         if ( iconName.startsWith( "image-" ))
-            icon = this->thumbnail( absolutePath, scale, upscale );
+            image = this->thumbnail( absolutePath, scale, upscale, cancelled );
 #ifdef Q_OS_WIN
         // get icon from executables
-        if ( iconName.startsWith( "application-x-ms-dos-executable" ) && !info.isSymLink())
-            icon = QIcon( this->extractPixmap( absolutePath, scale ));
+        if ( iconName.startsWith( "application-x-ms-dos-executable" ) && !meta.isSymLink())
+            image = this->extractImage( absolutePath, scale );
         // get icon from win32 shortcuts
-        if ( icon.isNull() && info.isSymLink())
-            icon = QIcon( this->extractPixmap( fileName, scale ));
+        if ( image.isNull() && meta.isSymLink())
+            image = this->extractImage( fileName, scale );
         // get icon from appref-ms files
-        if ( icon.isNull() && fileName.endsWith( ".appref-ms" ))
-            icon = QIcon( this->extractPixmap( fileName, scale ));
+        if ( image.isNull() && fileName.endsWith( ".appref-ms" ))
+            image = this->extractImage( fileName, scale );
+#endif
+    }
+
+    // cancelled while making a thumbnail
+    if ( cancelled && cancelled()) {
+#ifdef Q_OS_WIN
+        CoUninitialize();
 #endif
+        return QImage();
     }
 
     // get icon for mimetype
-    if ( icon.isNull()) {
+    if ( image.isNull()) {
         if ( isDir )
-            icon = this->icon( iconName, ":/icons/folder_scalable", scale );
+            image = this->image( iconName, scale, QString(), ":/icons/folder_scalable" );
         else
-            icon = this->icon( iconName, scale );
+            image = this->image( iconName, scale );
+#ifdef Q_OS_WIN
+        baseKey = QString( "%1_%2_%3" ).arg( iconName ).arg( IconIndex::instance()->defaultTheme()).arg( scale );
+#endif
     }
 #ifdef Q_OS_WIN
     // if mimetype icon fails (no custom icon theme, for example), get win32 shell icon
-    if ( icon.isNull()) {
-        QString alias;
-        icon = QIcon( this->extractPixmap( absolutePath, scale ));
-        alias = QString( "%1_%2_%3" ).arg( iconName ).arg( IconIndex::instance()->defaultTheme()).arg( scale );
+    if ( image.isNull()) {
+        image = this->extractImage( absolutePath, scale );
 
         // store shell icon in cache, to avoid unnecessary extractions
-        if ( !icon.isNull() && !this->cache.contains( alias ))
-            this->add( alias, icon );
+        if ( !image.isNull())
+            this->add( baseKey, image );
     }
 
     // add symlink label if required
-    if ( info.isSymLink() || fileName.endsWith( ".appref-ms" ))
-        icon = this->addSymlinkLabel( icon, scale );
+    if ( meta.isSymLink() || fileName.endsWith( ".appref-ms" ))
+        image = this->addSymlinkLabel( image, scale, baseKey );
 
     // uninitialize COM
     CoUninitialize();
 #endif
 
-    // return the icon
-    return icon;
+    // return the image
+    return image;
 }
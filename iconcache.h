@@ -22,9 +22,47 @@
 // includes
 //
 #include <QIcon>
+#include <QImage>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <functional>
+#include "filemeta.h"
+
+/**
+ * @brief The IconCacheNamespace namespace
+ */
+namespace IconCacheNamespace {
+    static const QString LinkOverlay( ":/icons/link" );
+}
+
+/**
+ * @brief IconCancelled returns true once the caller no longer needs the requested image
+ * (an empty function is never cancelled)
+ */
+typedef std::function<bool()> IconCancelled;
+
+/**
+ * @brief IconCallback receives a requested image (on the thread that computed it)
+ */
+typedef std::function<void( const QImage & )> IconCallback;
+
+/**
+ * @brief The IconFlight struct an in-flight image computation shared by concurrent callers
+ * (runs while at least one of them still wants the result, callers do not wait for it)
+ */
+struct IconFlight {
+    QList<IconCancelled> tokens;
+    QList<IconCallback> callbacks;
+};
 
 /**
  * @brief The IconCache class
+ *
+ * NOTE: icon() and iconForFilename() must only be called from the GUI thread,
+ *       worker threads use the QImage based image() and requestImageForFilename();
+ *       imageForFilename() never waits for a load in progress elsewhere, it returns a null
+ *       image instead and the result is announced with imageReady()
  */
 class IconCache final : public QObject {
     Q_OBJECT
@@ -34,25 +72,55 @@ public:
     ~IconCache() {}
     QIcon icon( const QString &iconName, int scale = 0, const QString theme = QString(), const QString &fallback = QString());
     QIcon icon( const QString &iconName, const QString &fallback = QString(), int scale = 0 ) { return this->icon( iconName, scale, QString(), fallback ); }
-    QIcon thumbnail( const QString &fileName, int scale, bool upscale = false );
-    QIcon addSymlinkLabel( const QIcon &icon, int originalSize );
-    QIcon iconForFilename( const QString &fileName, int scale, bool upscale = false );
+    QImage image( const QString &iconName, int scale = 0, const QString theme = QString(), const QString &fallback = QString());
+    QImage thumbnail( const QString &fileName, int scale, bool upscale = false, const IconCancelled &cancelled = IconCancelled());
+    QIcon iconForFilename( const QString &fileName, int scale, bool upscale = false ) { return QIcon( QPixmap::fromImage( this->imageForFilename( fileName, scale, upscale ))); }
+    QImage imageForFilename( const QString &fileName, int scale, bool upscale = false );
+    QImage imageForFilename( const FileMeta &meta, int scale, bool upscale = false );
+    void requestImageForFilename( const FileMeta &meta, int scale, bool upscale, const IconCancelled &cancelled, const IconCallback &callback );
+    QString iconKey( const FileMeta &meta, int scale ) const;
 #ifdef Q_OS_WIN
-    QPixmap extractPixmap( const QString &fileName, int scale );
+    QImage addSymlinkLabel( const QImage &image, int originalSize, const QString &baseKey = QString());
+    QImage linkOverlay( int overlaySize );
+    QImage extractImage( const QString &fileName, int scale );
     QString getDriveIconName( const QString &path ) const;
 #endif
     quint32 checksum( const char *data, size_t len ) const;
     quint32 hashForFile( const QString &fileName ) const;
     QString fileNameForHash( quint32 hash, int scale = 0 ) const;
-    QPixmap fastDownscale( const QPixmap &pixmap, int scale ) const;
+    QImage fastDownscale( const QImage &image, int scale ) const;
+    QImage readImage( const QString &fileName, int scale ) const;
+    int requestCount() const { return this->m_requests.load(); }
+    int coalescedCount() const { return this->m_coalesced.load(); }
+
+signals:
+    void imageReady( const QString &fileName, int scale, const QImage &image );
 
 private slots:
     void add( const QString &fileName, const QIcon &icon ) { this->cache[fileName] = icon; }
+    void add( const QString &alias, const QImage &image ) { QMutexLocker lock( &this->mutex ); this->images[alias] = image; }
+    void variableChanged( const QString &key );
 
 public slots:
-    void shutdown() { this->cache.clear(); }
+    void shutdown();
 
 private:
     IconCache( QObject *parent = nullptr );
+    void coalesce( const QString &key, const IconCancelled &cancelled, const IconCallback &callback, const std::function<QImage( const IconCancelled & )> &function );
+    static bool isCancelled( const IconFlight &flight );
+    QImage loadImageForFilename( const FileMeta &meta, int scale, bool upscale, const IconCancelled &cancelled );
+    QString fileKey( const FileMeta &meta, int scale ) const;
     QHash<QString, QIcon> cache;
+    QHash<QString, QImage> images;
+#ifdef Q_OS_WIN
+    // symlink labels are only drawn on Windows (shortcuts and appref-ms files)
+    QHash<int, QImage> overlays;
+    QHash<QString, QImage> composites;
+#endif
+    mutable QMutex mutex;
+    QAtomicInt m_symlinkLabels;
+    QHash<QString, QSharedPointer<IconFlight> > flights;
+    QMutex flightMutex;
+    QAtomicInt m_requests;
+    QAtomicInt m_coalesced;
 };
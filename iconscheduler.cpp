@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDebug>
+#include <QThread>
+#include <QtConcurrent>
+#include "iconscheduler.h"
+#include "main.h"
+
+/**
+ * @brief IconScheduler::IconScheduler
+ * @param parent
+ */
+IconScheduler::IconScheduler( QObject *parent ) : QObject( parent ), m_running( 0 ), m_scheduled( false ), m_next( 0 ) {
+    // announce
+#ifdef QT_DEBUG
+    qInfo() << this->tr( "initializing" );
+#endif
+
+    // one global thread cap for all views
+    this->pool.setMaxThreadCount( qMax( 2, QThread::idealThreadCount()));
+
+    // add to garbage collector
+    GarbageMan::instance()->add( this );
+}
+
+/**
+ * @brief IconScheduler::add
+ * @param queue
+ */
+void IconScheduler::add( IconQueue *queue ) {
+    if ( queue != nullptr && !this->queues.contains( queue ))
+        this->queues << queue;
+}
+
+/**
+ * @brief IconScheduler::remove (queue must not have any running tasks)
+ * @param queue
+ */
+void IconScheduler::remove( IconQueue *queue ) {
+    this->queues.removeAll( queue );
+
+    if ( this->m_next >= this->queues.count())
+        this->m_next = 0;
+}
+
+/**
+ * @brief IconScheduler::schedule requests a dispatch on the next event loop pass
+ */
+void IconScheduler::schedule() {
+    if ( this->m_scheduled )
+        return;
+
+    this->m_scheduled = true;
+    QMetaObject::invokeMethod( this, "dispatch", Qt::QueuedConnection );
+}
+
+/**
+ * @brief IconScheduler::shutdown
+ */
+void IconScheduler::shutdown() {
+    this->queues.clear();
+    this->pool.waitForDone();
+}
+
+/**
+ * @brief IconScheduler::nextQueue picks a queue with tasks from the highest priority class,
+ * rotating between queues of the same class
+ * @param exhausted queues that had no task to give during this pass
+ * @return
+ */
+IconQueue *IconScheduler::nextQueue( const QList<IconQueue*> &exhausted ) {
+    int priorityClass, y;
+
+    for ( priorityClass = 0; priorityClass < IconQueue::PriorityClassCount; priorityClass++ ) {
+        for ( y = 0; y < this->queues.count(); y++ ) {
+            const int index = ( this->m_next + y ) % this->queues.count();
+            IconQueue *queue = this->queues.at( index );
+
+            if ( !exhausted.contains( queue ) && queue->priorityClass() == priorityClass && queue->hasTasks()) {
+                this->m_next = ( index + 1 ) % this->queues.count();
+                return queue;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief IconScheduler::dispatch fills free worker threads with tasks
+ * NOTE: tasks are only taken when a thread is free, so views can still reorder their queues
+ */
+void IconScheduler::dispatch() {
+    QList<IconQueue*> exhausted;
+
+    this->m_scheduled = false;
+
+    while ( this->m_running.load() < this->pool.maxThreadCount()) {
+        IconQueue *queue = this->nextQueue( exhausted );
+        if ( queue == nullptr )
+            return;
+
+        // queue might have dropped its pending requests (out of viewport), try others
+        const std::function<void()> task( queue->takeTask());
+        if ( !task ) {
+            exhausted << queue;
+            continue;
+        }
+
+        this->m_running.ref();
+        QtConcurrent::run( &this->pool, [ this, task ] {
+            task();
+
+            // make room for the next task
+            this->m_running.deref();
+            QMetaObject::invokeMethod( this, "schedule", Qt::QueuedConnection );
+        } );
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QAtomicInt>
+#include <QList>
+#include <QThreadPool>
+#include <functional>
+
+/**
+ * @brief The IconQueue class per-view queue of icon tasks (implemented by models, GUI thread only)
+ */
+class IconQueue {
+public:
+    enum PriorityClasses {
+        NoClass = -1,
+        Visible,
+        Hidden,
+        PriorityClassCount
+    };
+
+    virtual ~IconQueue() {}
+    virtual PriorityClasses priorityClass() const = 0;
+    virtual bool hasTasks() const = 0;
+    virtual std::function<void()> takeTask() = 0;
+};
+
+/**
+ * @brief The IconScheduler class process-wide icon worker pool, takes tasks from view queues
+ * round-robin within a priority class (visible views always go before hidden ones)
+ */
+class IconScheduler final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( IconScheduler )
+
+public:
+    static IconScheduler *instance() { static IconScheduler *instance( new IconScheduler()); return instance; }
+    ~IconScheduler() {}
+    void add( IconQueue *queue );
+    void remove( IconQueue *queue );
+    int maxThreadCount() const { return this->pool.maxThreadCount(); }
+    int runningCount() const { return this->m_running.load(); }
+
+public slots:
+    void schedule();
+    void shutdown();
+
+private slots:
+    void dispatch();
+
+private:
+    explicit IconScheduler( QObject *parent = nullptr );
+    IconQueue *nextQueue( const QList<IconQueue*> &exhausted );
+    QList<IconQueue*> queues;
+    QThreadPool pool;
+    QAtomicInt m_running;
+    bool m_scheduled;
+    int m_next;
+};
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDebug>
+#include "iconstore.h"
+#include "main.h"
+
+/**
+ * @brief IconStore::IconStore
+ * @param parent
+ */
+IconStore::IconStore( QObject *parent ) : QObject( parent ) {
+    // announce
+#ifdef QT_DEBUG
+    qInfo() << this->tr( "initializing" );
+#endif
+
+    // add to garbage collector
+    GarbageMan::instance()->add( this );
+}
+
+/**
+ * @brief IconStore::insert stores an icon, unless another view has stored one first
+ * @param key
+ * @param icon
+ * @return icon in store
+ */
+QIcon IconStore::insert( const QString &key, const QIcon &icon ) {
+    if ( key.isEmpty())
+        return icon;
+
+    if ( !this->store.contains( key ))
+        this->store[key] = IconStoreEntry( icon );
+
+    return this->store[key].icon;
+}
+
+/**
+ * @brief IconStore::acquire
+ * @param key
+ */
+void IconStore::acquire( const QString &key ) {
+    if ( this->store.contains( key ))
+        this->store[key].references++;
+}
+
+/**
+ * @brief IconStore::release drops the icon once no view uses it
+ * @param key
+ */
+void IconStore::release( const QString &key ) {
+    const QHash<QString, IconStoreEntry>::iterator entry( this->store.find( key ));
+
+    if ( entry == this->store.end())
+        return;
+
+    entry->references--;
+    if ( entry->references <= 0 )
+        this->store.erase( entry );
+}
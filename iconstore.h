@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QIcon>
+
+/**
+ * @brief The IconStoreEntry struct (shared icon and the number of views using it)
+ */
+struct IconStoreEntry {
+    explicit IconStoreEntry( const QIcon &i = QIcon()) : icon( i ), references( 0 ) {}
+    QIcon icon;
+    int references;
+};
+
+/**
+ * @brief The IconStore class icons shared between views, keyed by icon identity
+ * (see IconCache::iconKey), must only be used from the GUI thread
+ */
+class IconStore final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( IconStore )
+
+public:
+    static IconStore *instance() { static IconStore *instance( new IconStore()); return instance; }
+    ~IconStore() {}
+    bool contains( const QString &key ) const { return this->store.contains( key ); }
+    QIcon icon( const QString &key ) const { return this->store.value( key ).icon; }
+    QIcon insert( const QString &key, const QIcon &icon );
+    void acquire( const QString &key );
+    void release( const QString &key );
+    int count() const { return this->store.count(); }
+
+public slots:
+    void shutdown() { this->store.clear(); }
+
+private:
+    explicit IconStore( QObject *parent = nullptr );
+    QHash<QString, IconStoreEntry> store;
+};
@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "imagescaler.h"
+#include <QVector>
+#include <cstring>
+
+//
+// SIMD paths
+//
+#if defined( Q_PROCESSOR_X86_64 ) || defined( __SSE2__ ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define IMAGESCALER_SSE2
+#include <emmintrin.h>
+#if defined( Q_CC_MSVC ) || defined( Q_CC_GNU ) || defined( Q_CC_CLANG )
+#define IMAGESCALER_AVX2
+#include <immintrin.h>
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#define IMAGESCALER_TARGET_AVX2
+#else
+#define IMAGESCALER_TARGET_AVX2 __attribute__(( target( "avx2" )))
+#endif
+#endif
+#endif
+
+#if defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define IMAGESCALER_NEON
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief RowFunction adds horizontal sums of 'factor' pixels into 'outWidth' channel accumulators
+ */
+typedef void ( *RowFunction )( const uchar *line, int outWidth, int factor, quint32 *acc );
+
+/**
+ * @brief sumRowGeneric
+ * @param line
+ * @param outWidth
+ * @param factor
+ * @param acc
+ */
+static void sumRowGeneric( const uchar *line, int outWidth, int factor, quint32 *acc ) {
+    int x, y;
+
+    for ( x = 0; x < outWidth; x++ ) {
+        const uchar *pixel = line + x * factor * 4;
+        quint32 c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+
+        for ( y = 0; y < factor; y++, pixel += 4 ) {
+            c0 += pixel[0];
+            c1 += pixel[1];
+            c2 += pixel[2];
+            c3 += pixel[3];
+        }
+
+        acc[x * 4 + 0] += c0;
+        acc[x * 4 + 1] += c1;
+        acc[x * 4 + 2] += c2;
+        acc[x * 4 + 3] += c3;
+    }
+}
+
+#ifdef IMAGESCALER_SSE2
+/**
+ * @brief sumPixelsSSE2 sums 'count' pixels channel-wise (4 pixels per iteration)
+ * @param pixel
+ * @param count
+ * @param sum
+ * @return
+ */
+static inline __m128i sumPixelsSSE2( const uchar *pixel, int count, __m128i sum ) {
+    const __m128i zero = _mm_setzero_si128();
+    int y = 0;
+
+    for ( ; y + 4 <= count; y += 4, pixel += 16 ) {
+        const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( pixel ));
+        const __m128i pairs = _mm_add_epi16( _mm_unpacklo_epi8( v, zero ), _mm_unpackhi_epi8( v, zero ));
+
+        sum = _mm_add_epi32( sum, _mm_unpacklo_epi16( pairs, zero ));
+        sum = _mm_add_epi32( sum, _mm_unpackhi_epi16( pairs, zero ));
+    }
+
+    for ( ; y < count; y++, pixel += 4 ) {
+        int value;
+
+        memcpy( &value, pixel, sizeof( value ));
+        sum = _mm_add_epi32( sum, _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( value ), zero ), zero ));
+    }
+
+    return sum;
+}
+
+/**
+ * @brief sumRowSSE2
+ * @param line
+ * @param outWidth
+ * @param factor
+ * @param acc
+ */
+static void sumRowSSE2( const uchar *line, int outWidth, int factor, quint32 *acc ) {
+    int x;
+
+    for ( x = 0; x < outWidth; x++ ) {
+        __m128i *out = reinterpret_cast<__m128i *>( acc + x * 4 );
+        const __m128i sum = sumPixelsSSE2( line + x * factor * 4, factor, _mm_setzero_si128());
+
+        _mm_storeu_si128( out, _mm_add_epi32( _mm_loadu_si128( out ), sum ));
+    }
+}
+#endif
+
+#ifdef IMAGESCALER_AVX2
+/**
+ * @brief hasAVX2
+ * @return
+ */
+static bool hasAVX2() {
+#ifdef Q_CC_MSVC
+    int info[4];
+
+    __cpuid( info, 0 );
+    if ( info[0] < 7 )
+        return false;
+
+    // OSXSAVE and AVX, then check that the OS saves ymm registers
+    __cpuid( info, 1 );
+    if (( info[2] & (( 1 << 27 ) | ( 1 << 28 ))) != (( 1 << 27 ) | ( 1 << 28 )))
+        return false;
+
+    if (( _xgetbv( 0 ) & 0x6 ) != 0x6 )
+        return false;
+
+    __cpuidex( info, 7, 0 );
+    return ( info[1] & ( 1 << 5 )) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+#endif
+}
+
+/**
+ * @brief sumRowAVX2
+ * @param line
+ * @param outWidth
+ * @param factor
+ * @param acc
+ */
+IMAGESCALER_TARGET_AVX2 static void sumRowAVX2( const uchar *line, int outWidth, int factor, quint32 *acc ) {
+    const __m256i zero = _mm256_setzero_si256();
+    int x, y;
+
+    for ( x = 0; x < outWidth; x++ ) {
+        const uchar *pixel = line + x * factor * 4;
+        __m128i *out = reinterpret_cast<__m128i *>( acc + x * 4 );
+        __m256i wide = zero;
+
+        // 8 pixels per iteration (4 per 128-bit lane)
+        for ( y = 0; y + 8 <= factor; y += 8, pixel += 32 ) {
+            const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i *>( pixel ));
+            const __m256i pairs = _mm256_add_epi16( _mm256_unpacklo_epi8( v, zero ), _mm256_unpackhi_epi8( v, zero ));
+
+            wide = _mm256_add_epi32( wide, _mm256_unpacklo_epi16( pairs, zero ));
+            wide = _mm256_add_epi32( wide, _mm256_unpackhi_epi16( pairs, zero ));
+        }
+
+        // fold lanes and finish the tail
+        const __m128i sum = sumPixelsSSE2( pixel, factor - y, _mm_add_epi32( _mm256_castsi256_si128( wide ), _mm256_extracti128_si256( wide, 1 )));
+        _mm_storeu_si128( out, _mm_add_epi32( _mm_loadu_si128( out ), sum ));
+    }
+}
+#endif
+
+#ifdef IMAGESCALER_NEON
+/**
+ * @brief sumRowNEON
+ * @param line
+ * @param outWidth
+ * @param factor
+ * @param acc
+ */
+static void sumRowNEON( const uchar *line, int outWidth, int factor, quint32 *acc ) {
+    int x, y;
+
+    for ( x = 0; x < outWidth; x++ ) {
+        const uchar *pixel = line + x * factor * 4;
+        uint32x4_t sum = vdupq_n_u32( 0 );
+
+        for ( y = 0; y + 4 <= factor; y += 4, pixel += 16 ) {
+            const uint8x16_t v = vld1q_u8( pixel );
+            const uint16x8_t pairs = vaddl_u8( vget_low_u8( v ), vget_high_u8( v ));
+
+            sum = vaddw_u16( sum, vget_low_u16( pairs ));
+            sum = vaddw_u16( sum, vget_high_u16( pairs ));
+        }
+
+        for ( ; y < factor; y++, pixel += 4 ) {
+            quint32 value;
+
+            memcpy( &value, pixel, sizeof( value ));
+            sum = vaddw_u16( sum, vget_low_u16( vmovl_u8( vreinterpret_u8_u32( vdup_n_u32( value )))));
+        }
+
+        vst1q_u32( acc + x * 4, vaddq_u32( vld1q_u32( acc + x * 4 ), sum ));
+    }
+}
+#endif
+
+/**
+ * @brief rowFunction
+ * @return
+ */
+static RowFunction rowFunction() {
+    static const RowFunction function = []() -> RowFunction {
+        switch ( ImageScaler::kernel()) {
+#ifdef IMAGESCALER_AVX2
+        case ImageScaler::AVX2:
+            return sumRowAVX2;
+#endif
+#ifdef IMAGESCALER_SSE2
+        case ImageScaler::SSE2:
+            return sumRowSSE2;
+#endif
+#ifdef IMAGESCALER_NEON
+        case ImageScaler::NEON:
+            return sumRowNEON;
+#endif
+        default:
+            return sumRowGeneric;
+        }
+    }();
+
+    return function;
+}
+
+/**
+ * @brief ImageScaler::kernel returns the fastest kernel supported by the cpu
+ * @return
+ */
+ImageScaler::Kernels ImageScaler::kernel() {
+    static const Kernels kernel = []() -> Kernels {
+#ifdef IMAGESCALER_AVX2
+        if ( hasAVX2())
+            return AVX2;
+#endif
+#if defined( IMAGESCALER_SSE2 )
+        return SSE2;
+#elif defined( IMAGESCALER_NEON )
+        return NEON;
+#else
+        return Generic;
+#endif
+    }();
+
+    return kernel;
+}
+
+/**
+ * @brief ImageScaler::boxDownscale averages each xFactor * yFactor block of pixels into one
+ * (remainder columns and rows that do not fill a whole block are dropped)
+ * @param image
+ * @param xFactor
+ * @param yFactor
+ * @return
+ */
+QImage ImageScaler::boxDownscale( const QImage &image, int xFactor, int yFactor ) {
+    int x, y, k;
+
+    if ( image.isNull() || xFactor < 1 || yFactor < 1 )
+        return QImage();
+
+    // premultiplied alpha can be averaged directly
+    const QImage source( image.format() == QImage::Format_ARGB32_Premultiplied ? image : image.convertToFormat( QImage::Format_ARGB32_Premultiplied ));
+    const int width = source.width() / xFactor;
+    const int height = source.height() / yFactor;
+
+    if ( width <= 0 || height <= 0 )
+        return QImage();
+
+    if ( xFactor == 1 && yFactor == 1 )
+        return source;
+
+    QImage result( width, height, QImage::Format_ARGB32_Premultiplied );
+    if ( result.isNull())
+        return result;
+
+    const RowFunction sumRow = rowFunction();
+    const quint32 area = static_cast<quint32>( xFactor * yFactor );
+    QVector<quint32> acc( width * 4 );
+
+    for ( y = 0; y < height; y++ ) {
+        uchar *line = result.scanLine( y );
+
+        // accumulate yFactor source lines
+        acc.fill( 0 );
+        for ( k = 0; k < yFactor; k++ )
+            sumRow( source.constScanLine( y * yFactor + k ), width, xFactor, acc.data());
+
+        // normalize with rounding
+        for ( x = 0; x < width * 4; x++ )
+            line[x] = static_cast<uchar>(( acc.at( x ) + area / 2 ) / area );
+    }
+
+    return result;
+}
+
+/**
+ * @brief ImageScaler::downscale reduces by the largest integer ratio with a box filter,
+ * then finishes the remaining (less than 2x) fractional step with a smooth transformation
+ * @param image
+ * @param width
+ * @param height
+ * @return
+ */
+QImage ImageScaler::downscale( const QImage &image, int width, int height ) {
+    QImage result;
+
+    if ( image.isNull() || width <= 0 || height <= 0 )
+        return QImage();
+
+    const int xFactor = qMax( 1, image.width() / width );
+    const int yFactor = qMax( 1, image.height() / height );
+
+    if ( xFactor > 1 || yFactor > 1 )
+        result = ImageScaler::boxDownscale( image, xFactor, yFactor );
+    else
+        result = image.convertToFormat( QImage::Format_ARGB32_Premultiplied );
+
+    if ( result.width() != width || result.height() != height )
+        result = result.scaled( width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation );
+
+    return result;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QImage>
+
+/**
+ * @brief The ImageScaler class area-averaging (box filter) downscaler for ARGB32_Premultiplied images
+ */
+class ImageScaler final {
+public:
+    // available kernels (selected at runtime)
+    enum Kernels {
+        NoKernel = -1,
+        Generic,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    static QImage downscale( const QImage &image, int width, int height );
+    static QImage downscale( const QImage &image, int scale ) { return ImageScaler::downscale( image, scale, scale ); }
+    static QImage boxDownscale( const QImage &image, int xFactor, int yFactor );
+    static Kernels kernel();
+
+private:
+    ImageScaler() = delete;
+};
@@ -22,7 +22,7 @@
 #include <QDebug>
 #include <QDir>
 #include <QDomDocument>
-#include <QPixmap>
+#include <QImageReader>
 #include <QIcon>
 #include "indexcache.h"
 #include "iconindex.h"
@@ -267,11 +267,8 @@ Match IndexCache::readIconFile( const QString &fileName, bool &ok, int recursion
             return this->readIconFile( link, ok, recursionLevel );
         }
     } else {
-        QPixmap pixmap;
-
-        // get size directly from pixmap
-        if ( pixmap.load( fileName ))
-            iconMatch.scale = pixmap.width();
+        // get size from image header (no decoding required)
+        iconMatch.scale = QImageReader( fileName ).size().width();
     }
 
     // check scale
@@ -386,22 +383,38 @@ Match IndexCache::bestMatch( const QString &iconName, int scale, const QString &
  * @return
  */
 QIcon IndexCache::icon( const QString &iconName, int scale, const QString &theme ) {
+    const QString fileName( this->fileName( iconName, scale, theme ));
+
+    if ( fileName.isEmpty())
+        return QIcon();
+
+    return QIcon( fileName );
+}
+
+/**
+ * @brief IndexCache::fileName returns the best matching icon file (safe to call from worker threads)
+ * @param iconName
+ * @param scale
+ * @param theme
+ * @return
+ */
+QString IndexCache::fileName( const QString &iconName, int scale, const QString &theme ) {
+    QMutexLocker lock( &this->mutex );
     Match match;
 
     // check if icon is already cache
     const QString alias( QString( "%1_%2_%3" ).arg( iconName ).arg( theme ).arg( scale ));
     if ( this->contains( alias ))
-        return QIcon( this->indexEntry( alias ).fileName );
+        return this->indexEntry( alias ).fileName;
 
     // get best match
     match = this->bestMatch( iconName, scale, theme );
 
     // write out to cache
     if ( match.scale >= 0 ) {
-        // NOTE: write operation should not be called from multiple threads
         this->write( iconName, scale, theme, match.fileName );
-        return QIcon( match.fileName );
+        return match.fileName;
     }
 
-    return QIcon();
+    return QString();
 }
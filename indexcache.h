@@ -22,6 +22,7 @@
 // includes
 //
 #include <QHash>
+#include <QMutex>
 #include "filestream.h"
 
 /**
@@ -73,6 +74,7 @@ public:
     static IndexCache *instance() { static IndexCache *instance( new IndexCache()); return instance; }
     ~IndexCache() {}
     QIcon icon( const QString &iconName, int scale, const QString &theme );
+    QString fileName( const QString &iconName, int scale, const QString &theme );
     QString path() const { return this->m_path; }
     int badEntries() const { return this->m_badEntries; }
 
@@ -99,4 +101,5 @@ private:
     bool contains( const QString &alias ) const { return this->index.contains( alias ); }
     Entry indexEntry( const QString &alias ) const { return this->index[alias]; }
     int m_badEntries;
+    QMutex mutex;
 };
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QKeyEvent>
+#include <QStyle>
+#include "launcher.h"
+#include "launcherindex.h"
+#include "iconcache.h"
+#include "ui_launcher.h"
+
+/**
+ * @brief Launcher::Launcher
+ * @param parent
+ */
+Launcher::Launcher( QWidget *parent ) : QDialog( parent ), ui( new Ui::Launcher ) {
+    this->ui->setupUi( this );
+    this->setWindowFlags( this->windowFlags() | Qt::WindowStaysOnTopHint );
+    this->setWindowIcon( IconCache::instance()->icon( "system-search", ":/icons/find", 16 ));
+
+    // results are navigated from the query field
+    this->ui->query->installEventFilter( this );
+
+    // index might change while searching (scans, watcher events)
+    this->connect( LauncherIndex::instance(), SIGNAL( updated()), this, SLOT( refresh()));
+
+    // icons loaded elsewhere at the same time arrive later
+    this->connect( IconCache::instance(), SIGNAL( imageReady( QString, int, QImage )), this, SLOT( imageReady( QString, int, QImage )));
+}
+
+/**
+ * @brief Launcher::~Launcher
+ */
+Launcher::~Launcher() {
+    this->disconnect( LauncherIndex::instance(), SIGNAL( updated()), this, SLOT( refresh()));
+    this->disconnect( IconCache::instance(), SIGNAL( imageReady( QString, int, QImage )), this, SLOT( imageReady( QString, int, QImage )));
+    delete this->ui;
+}
+
+/**
+ * @brief Launcher::refresh lists best matches of the query
+ */
+void Launcher::refresh() {
+    if ( !this->isVisible())
+        return;
+
+    // icons being loaded elsewhere are null for now (set in imageReady)
+    const QIcon fallback( this->style()->standardIcon( QStyle::SP_FileIcon ));
+
+    this->ui->results->clear();
+    foreach ( const LauncherEntry &entry, LauncherIndex::instance()->find( this->ui->query->text())) {
+        const QIcon icon( IconCache::instance()->iconForFilename( entry.path, 16 ));
+        QListWidgetItem *item( new QListWidgetItem( icon.isNull() ? fallback : icon, entry.path.mid( entry.path.lastIndexOf( '/' ) + 1 ), this->ui->results ));
+
+        item->setToolTip( entry.path );
+        item->setData( Qt::UserRole, entry.path );
+    }
+
+    if ( this->ui->results->count())
+        this->ui->results->setCurrentRow( 0 );
+}
+
+/**
+ * @brief Launcher::imageReady sets icons of results that have been loaded elsewhere
+ * @param fileName
+ * @param scale
+ * @param image
+ */
+void Launcher::imageReady( const QString &fileName, int scale, const QImage &image ) {
+    int y;
+
+    if ( image.isNull() || scale != 16 )
+        return;
+
+    for ( y = 0; y < this->ui->results->count(); y++ ) {
+        QListWidgetItem *item( this->ui->results->item( y ));
+
+        if ( !QString::compare( item->data( Qt::UserRole ).toString(), fileName ))
+            item->setIcon( QIcon( QPixmap::fromImage( image )));
+    }
+}
+
+/**
+ * @brief Launcher::eventFilter moves through results while typing
+ * @param object
+ * @param event
+ * @return
+ */
+bool Launcher::eventFilter( QObject *object, QEvent *event ) {
+    if ( object == this->ui->query && event->type() == QEvent::KeyPress ) {
+        const QKeyEvent *keyEvent( static_cast<QKeyEvent*>( event ));
+        const int row = this->ui->results->currentRow();
+
+        switch ( keyEvent->key()) {
+        case Qt::Key_Up:
+            if ( row > 0 )
+                this->ui->results->setCurrentRow( row - 1 );
+            return true;
+
+        case Qt::Key_Down:
+            if ( row < this->ui->results->count() - 1 )
+                this->ui->results->setCurrentRow( row + 1 );
+            return true;
+
+        case Qt::Key_Return:
+        case Qt::Key_Enter:
+            if ( this->ui->results->currentItem() != nullptr )
+                this->on_results_itemActivated( this->ui->results->currentItem());
+            return true;
+
+        default:
+            break;
+        }
+    }
+
+    return QDialog::eventFilter( object, event );
+}
+
+/**
+ * @brief Launcher::showEvent starts with an empty query (and catches up with new roots)
+ * @param event
+ */
+void Launcher::showEvent( QShowEvent *event ) {
+    LauncherIndex::instance()->update();
+
+    this->ui->query->clear();
+    this->ui->query->setFocus();
+    this->ui->results->clear();
+
+    QDialog::showEvent( event );
+}
+
+/**
+ * @brief Launcher::on_results_itemActivated
+ * @param item
+ */
+void Launcher::on_results_itemActivated( QListWidgetItem *item ) {
+    LauncherIndex::instance()->launch( item->data( Qt::UserRole ).toString());
+    this->accept();
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QDialog>
+#include <QListWidgetItem>
+
+//
+// namespaces
+//
+namespace Ui {
+class Launcher;
+}
+
+/**
+ * @brief The Launcher class
+ */
+class Launcher : public QDialog {
+    Q_OBJECT
+    Q_CLASSINFO( "description", "Quick launcher for files in all widgets" )
+
+public:
+    explicit Launcher( QWidget *parent = nullptr );
+    ~Launcher();
+
+public slots:
+    void refresh();
+
+protected:
+    bool eventFilter( QObject *object, QEvent *event );
+    void showEvent( QShowEvent *event );
+
+private slots:
+    void on_query_textChanged( const QString & ) { this->refresh(); }
+    void on_results_itemActivated( QListWidgetItem *item );
+    void imageReady( const QString &fileName, int scale, const QImage &image );
+
+private:
+    Ui::Launcher *ui;
+};
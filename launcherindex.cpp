@@ -0,0 +1,689 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDebug>
+#include <QDesktopServices>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QUrl>
+#include <QtConcurrent>
+#include <algorithm>
+#include "launcherindex.h"
+#include "foldermanager.h"
+#include "indexcache.h"
+#include "main.h"
+#ifdef Q_OS_LINUX
+#include "filewatcher.h"
+#endif
+
+/**
+ * @brief The LauncherMatch struct (search result with its ranking keys)
+ */
+struct LauncherMatch {
+    int slot;
+    int rank;
+    int hits;
+    int length;
+};
+
+/**
+ * @brief childPath
+ * @param path
+ * @param name
+ * @return
+ */
+static inline QString childPath( const QString &path, const QString &name ) {
+    return path.endsWith( '/' ) ? path + name : path + "/" + name;
+}
+
+/**
+ * @brief parentPath
+ * @param path
+ * @return
+ */
+static inline QString parentPath( const QString &path ) {
+    const int index = path.lastIndexOf( '/' );
+
+    return index > 0 ? path.left( index ) : path.left( index + 1 );
+}
+
+/**
+ * @brief LauncherIndex::LauncherIndex
+ * @param parent
+ */
+LauncherIndex::LauncherIndex( QObject *parent ) : QObject( parent ), m_valid( false ) {
+    // announce
+#ifdef QT_DEBUG
+    qInfo() << this->tr( "initializing" );
+#endif
+
+    // set up index file next to the icon index
+    this->indexFile.setFilename( IndexCache::instance()->path() + "/" + LauncherIndexNamespace::IndexFilename );
+    if ( !this->indexFile.open()) {
+        qCritical() << this->tr( "launcher index file non-writable" );
+    } else {
+        // a bad index is not fatal, roots are scanned anyway
+        if ( this->indexFile.size() && !this->read()) {
+            this->entries.clear();
+            this->freeSlots.clear();
+            this->slotForPath.clear();
+            this->children.clear();
+            this->frequency.clear();
+            this->searchIndex.clear();
+            this->m_roots.clear();
+        }
+
+        this->m_valid = true;
+    }
+
+    // listen for scan results and directory changes
+    this->connect( &this->scanWatcher, SIGNAL( finished()), this, SLOT( scanFinished()));
+#ifdef Q_OS_LINUX
+    this->connect( FileWatcher::instance(), SIGNAL( changed( QString, QSet<QString> )), this, SLOT( directoryChanged( QString, QSet<QString> )));
+    this->connect( FileWatcher::instance(), SIGNAL( lost( QString )), this, SLOT( directoryLost( QString )));
+#endif
+
+    // add to garbage collector
+    GarbageMan::instance()->add( this );
+}
+
+/**
+ * @brief LauncherIndex::read
+ * @return
+ */
+bool LauncherIndex::read() {
+    quint8 version;
+    QString path;
+    bool directory;
+    int count, y;
+
+    // read index file version
+    this->indexFile.toStart();
+    this->indexFile >> version;
+
+    // check version
+    if ( version != LauncherIndexNamespace::Version ) {
+        qCritical() << this->tr( "version mismatch for launcher index file" );
+        return false;
+    }
+
+    // read roots, launch counts and entries
+    this->indexFile >> this->m_roots >> this->frequency >> count;
+    for ( y = 0; y < count && this->indexFile.status() == QDataStream::Ok; y++ ) {
+        this->indexFile >> path >> directory;
+        this->insert( path, directory );
+    }
+
+    if ( this->indexFile.status() != QDataStream::Ok ) {
+        this->indexFile.resetStatus();
+        qCritical() << this->tr( "truncated launcher index file" );
+        return false;
+    }
+
+    // report
+    qInfo() << this->tr( "found %1 entries in launcher index file" ).arg( this->count());
+
+    // return success
+    return true;
+}
+
+/**
+ * @brief LauncherIndex::write rewrites the index file (launch counts of files that are gone are dropped)
+ */
+void LauncherIndex::write() {
+    QHash<QString, int> frequency;
+    QHash<QString, int>::const_iterator i;
+
+    for ( i = this->frequency.constBegin(); i != this->frequency.constEnd(); ++i ) {
+        if ( this->slotForPath.contains( i.key()))
+            frequency[i.key()] = i.value();
+    }
+
+    this->indexFile.clear();
+    this->indexFile.toStart();
+    this->indexFile << LauncherIndexNamespace::Version << this->m_roots << frequency << this->count();
+
+    foreach ( const LauncherEntry &entry, this->entries ) {
+        if ( entry.isValid())
+            this->indexFile << entry.path << entry.directory;
+    }
+    this->indexFile.sync();
+}
+
+/**
+ * @brief LauncherIndex::shutdown
+ */
+void LauncherIndex::shutdown() {
+    // a running scan is bounded (depth and entry count), just wait for it
+    this->pendingRoots.clear();
+    this->scanWatcher.disconnect( this );
+    this->scanWatcher.waitForFinished();
+
+    foreach ( const QString &path, this->watched )
+        this->unwatch( path );
+
+    if ( !this->m_valid )
+        return;
+
+    // set subsystem as inactive and close the index file
+    this->write();
+    this->m_valid = false;
+    this->indexFile.close();
+}
+
+/**
+ * @brief LauncherIndex::update syncs roots with folder widgets and desktop icons and scans new ones
+ */
+void LauncherIndex::update() {
+    QStringList roots, removed, paths, directories;
+    int y;
+
+    // collect roots (desktop icons pointing to files are already a click away)
+    for ( y = 0; y < FolderManager::instance()->count(); y++ ) {
+        const QString path( QDir::cleanPath( FolderManager::instance()->at( y )->rootPath()));
+
+        if ( !path.isEmpty() && !roots.contains( path ))
+            roots << path;
+    }
+
+    for ( y = 0; y < FolderManager::instance()->iconCount(); y++ ) {
+        const QFileInfo info( FolderManager::instance()->iconAt( y )->target());
+        const QString path( QDir::cleanPath( info.absoluteFilePath()));
+
+        if ( info.isDir() && !roots.contains( path ))
+            roots << path;
+    }
+
+    // forget roots that are no longer used (unless covered by another root)
+    foreach ( const QString &root, this->m_roots ) {
+        if ( !roots.contains( root ))
+            removed << root;
+    }
+    this->m_roots = roots;
+
+    foreach ( const QString &root, removed ) {
+        this->pendingRoots.removeAll( root );
+        this->scannedRoots.remove( root );
+
+        // walk contents of the root, entries covered by another root stay (with their contents)
+        paths.clear();
+        directories = QStringList( root );
+        while ( !directories.isEmpty()) {
+            foreach ( const QString &child, this->children.value( directories.takeFirst())) {
+                if ( this->depth( child ) >= 0 )
+                    continue;
+
+                paths << child;
+                directories << child;
+            }
+        }
+
+        foreach ( const QString &path, paths )
+            this->detach( path );
+
+        if ( this->depth( root ) < 0 )
+            this->unwatch( root );
+    }
+
+#ifndef Q_OS_LINUX
+    // without a watcher, list indexed directories that changed since they were listed
+    foreach ( const QString &path, this->watched.toList()) {
+        if ( this->watched.contains( path ) && QFileInfo( path ).lastModified() != this->modified.value( path ))
+            this->refresh( path );
+    }
+#endif
+
+    // scan new roots (all of them on startup to catch up with changes made in the meantime)
+    foreach ( const QString &root, roots ) {
+        if ( this->scannedRoots.contains( root ))
+            continue;
+
+        if ( !this->pendingRoots.contains( root ))
+            this->pendingRoots << root;
+    }
+    this->scanNext();
+
+    if ( !removed.isEmpty())
+        emit this->updated();
+}
+
+/**
+ * @brief LauncherIndex::scan lists a root down to MaximumDepth (runs in a worker thread)
+ * @param root
+ * @return
+ */
+LauncherScan LauncherIndex::scan( const QString &root ) {
+    LauncherScan result;
+    QStringList directories( root );
+    int level;
+
+    result.root = root;
+    for ( level = 1; level <= LauncherIndexNamespace::MaximumDepth && !directories.isEmpty(); level++ ) {
+        QStringList next;
+
+        foreach ( const QString &directory, directories ) {
+#ifndef Q_OS_LINUX
+            // taken before listing, changes made while listing are caught on the next update
+            result.modified[directory] = QFileInfo( directory ).lastModified();
+#endif
+            QDirIterator it( directory, QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System );
+
+            while ( it.hasNext() && result.paths.count() < LauncherIndexNamespace::MaximumEntries ) {
+                it.next();
+
+                // do not follow symlinked directories (loops)
+                const QString path( childPath( directory, it.fileName()));
+                const bool isDirectory = it.fileInfo().isDir() && !it.fileInfo().isSymLink();
+
+                result.paths << path;
+                result.directories << isDirectory;
+
+                if ( isDirectory )
+                    next << path;
+            }
+        }
+
+        directories = next;
+    }
+
+    return result;
+}
+
+/**
+ * @brief LauncherIndex::scanNext scans roots one at a time
+ */
+void LauncherIndex::scanNext() {
+    if ( this->scanWatcher.isRunning() || this->pendingRoots.isEmpty())
+        return;
+
+    this->scanWatcher.setFuture( QtConcurrent::run( &LauncherIndex::scan, this->pendingRoots.takeFirst()));
+}
+
+/**
+ * @brief LauncherIndex::scanFinished replaces contents of a root with scan results
+ */
+void LauncherIndex::scanFinished() {
+    const LauncherScan result( this->scanWatcher.result());
+    QStringList removed, directories;
+    QSet<QString> found;
+    QHash<QString, QDateTime>::const_iterator i;
+    int y;
+
+    // root was removed while scanning
+    if ( this->m_roots.contains( result.root )) {
+        found = result.paths.toSet();
+
+        // drop entries that are gone (entries covered by other roots are theirs to drop)
+        directories = QStringList( result.root );
+        while ( !directories.isEmpty()) {
+            foreach ( const QString &child, this->children.value( directories.takeFirst())) {
+                if ( this->depth( child, result.root ) >= 0 )
+                    continue;
+
+                if ( !found.contains( child ))
+                    removed << child;
+                else
+                    directories << child;
+            }
+        }
+
+        foreach ( const QString &path, removed )
+            this->remove( path );
+
+        for ( i = result.modified.constBegin(); i != result.modified.constEnd(); ++i )
+            this->modified[i.key()] = i.value();
+
+        // add new entries and watch directories that are indexed
+        this->watch( result.root );
+        for ( y = 0; y < result.paths.count(); y++ ) {
+            this->insert( result.paths.at( y ), result.directories.at( y ));
+
+            if ( result.directories.at( y ) && this->depth( result.paths.at( y )) < LauncherIndexNamespace::MaximumDepth )
+                this->watch( result.paths.at( y ));
+        }
+
+        this->scannedRoots << result.root;
+#ifdef QT_DEBUG
+        qInfo() << this->tr( "indexed %1 entries in \"%2\"" ).arg( result.paths.count()).arg( result.root );
+#endif
+        emit this->updated();
+    }
+
+    this->scanNext();
+}
+
+/**
+ * @brief LauncherIndex::depth returns how deep the path is below the nearest root
+ * @param path
+ * @param excludedRoot root to ignore
+ * @return -1 if the path is not under any root
+ */
+int LauncherIndex::depth( const QString &path, const QString &excludedRoot ) const {
+    int minimum = -1;
+
+    foreach ( const QString &root, this->m_roots ) {
+        const QString prefix( childPath( root, QString()));
+        int level;
+
+        if ( !QString::compare( root, excludedRoot ))
+            continue;
+
+        if ( !QString::compare( root, path ))
+            return 0;
+
+        if ( !path.startsWith( prefix ))
+            continue;
+
+        level = path.midRef( prefix.length()).count( '/' ) + 1;
+        if ( minimum < 0 || level < minimum )
+            minimum = level;
+    }
+
+    return minimum;
+}
+
+/**
+ * @brief LauncherIndex::insert
+ * @param path
+ * @param directory
+ */
+void LauncherIndex::insert( const QString &path, bool directory ) {
+    int slot;
+
+    if ( this->slotForPath.contains( path )) {
+        this->entries[this->slotForPath[path]].directory = directory;
+        return;
+    }
+
+    if ( this->count() >= LauncherIndexNamespace::MaximumEntries )
+        return;
+
+    if ( !this->freeSlots.isEmpty()) {
+        slot = this->freeSlots.takeLast();
+        this->entries[slot] = LauncherEntry( path, directory );
+    } else {
+        slot = this->entries.count();
+        this->entries << LauncherEntry( path, directory );
+    }
+
+    this->slotForPath[path] = slot;
+    this->children[parentPath( path )] << path;
+    this->searchIndex.insert( static_cast<quintptr>( slot ), this->entries.at( slot ).name );
+}
+
+/**
+ * @brief LauncherIndex::remove removes an entry (and contents if it is a directory)
+ * @param path
+ */
+void LauncherIndex::remove( const QString &path ) {
+    int slot;
+
+    // contents are only indexed for directories
+    slot = this->slotForPath.value( path, -1 );
+    if ( slot >= 0 && this->entries.at( slot ).directory ) {
+        foreach ( const QString &child, this->children.value( path ))
+            this->remove( child );
+    }
+
+    this->detach( path );
+}
+
+/**
+ * @brief LauncherIndex::detach removes a single entry (contents of a directory are kept)
+ * @param path
+ */
+void LauncherIndex::detach( const QString &path ) {
+    const QString parent( parentPath( path ));
+    QHash<QString, QSet<QString> >::iterator siblings;
+    int slot;
+
+    this->unwatch( path );
+
+    slot = this->slotForPath.value( path, -1 );
+    if ( slot < 0 )
+        return;
+
+    this->slotForPath.remove( path );
+    this->searchIndex.remove( static_cast<quintptr>( slot ));
+    this->entries[slot] = LauncherEntry();
+    this->freeSlots << slot;
+
+    siblings = this->children.find( parent );
+    if ( siblings != this->children.end()) {
+        siblings->remove( path );
+
+        if ( siblings->isEmpty())
+            this->children.erase( siblings );
+    }
+}
+
+/**
+ * @brief LauncherIndex::refresh updates changed entries of a watched directory
+ * @param path
+ * @param names changed names (empty to list the whole directory)
+ */
+void LauncherIndex::refresh( const QString &path, const QSet<QString> &names ) {
+    const QString prefix( childPath( path, QString()));
+    const int level = this->depth( path );
+    QSet<QString> changed( names );
+
+    // not indexed (anymore)
+    if ( level < 0 || level >= LauncherIndexNamespace::MaximumDepth )
+        return;
+
+    // list the whole directory, this also catches entries removed in the meantime
+    if ( changed.isEmpty()) {
+        const QDir directory( path );
+
+        if ( !directory.exists()) {
+            foreach ( const QString &child, this->children.value( path ))
+                this->remove( child );
+
+            if ( level > 0 )
+                this->remove( path );
+
+            emit this->updated();
+            return;
+        }
+
+#ifndef Q_OS_LINUX
+        // taken before listing, changes made while listing are caught on the next update
+        this->modified[path] = QFileInfo( path ).lastModified();
+#endif
+        changed = directory.entryList( QDir::AllEntries | QDir::NoDotAndDotDot | QDir::System ).toSet();
+        foreach ( const QString &child, this->children.value( path ))
+            changed << child.mid( prefix.length());
+    }
+
+    foreach ( const QString &name, changed ) {
+        const QString child( childPath( path, name ));
+        const QFileInfo info( child );
+        bool isDirectory;
+
+        if ( !info.exists() || info.isHidden()) {
+            this->remove( child );
+            continue;
+        }
+
+        isDirectory = info.isDir() && !info.isSymLink();
+        if ( !isDirectory && this->watched.contains( child ))
+            this->remove( child );
+
+        this->insert( child, isDirectory );
+
+        // new subdirectory, index its contents as well
+        if ( isDirectory && level + 1 < LauncherIndexNamespace::MaximumDepth && !this->watched.contains( child )) {
+            this->watch( child );
+            this->refresh( child );
+        }
+    }
+
+    emit this->updated();
+}
+
+/**
+ * @brief LauncherIndex::directoryChanged
+ * @param path
+ * @param names
+ */
+void LauncherIndex::directoryChanged( const QString &path, const QSet<QString> &names ) {
+    if ( !this->watched.contains( path ) || names.isEmpty())
+        return;
+
+    this->refresh( path, names );
+}
+
+/**
+ * @brief LauncherIndex::directoryLost lists the directory again after lost events or if it was
+ * removed or moved
+ * @param path
+ */
+void LauncherIndex::directoryLost( const QString &path ) {
+    if ( !this->watched.contains( path ))
+        return;
+
+    this->refresh( path );
+}
+
+/**
+ * @brief LauncherIndex::watch
+ * @param path
+ */
+void LauncherIndex::watch( const QString &path ) {
+    if ( this->watched.contains( path ))
+        return;
+
+    this->watched << path;
+#ifdef Q_OS_LINUX
+    FileWatcher::instance()->watch( path );
+#endif
+}
+
+/**
+ * @brief LauncherIndex::unwatch
+ * @param path
+ */
+void LauncherIndex::unwatch( const QString &path ) {
+    if ( !this->watched.remove( path ))
+        return;
+
+    this->modified.remove( path );
+
+#ifdef Q_OS_LINUX
+    FileWatcher::instance()->unwatch( path );
+#endif
+}
+
+/**
+ * @brief LauncherIndex::rank ranks a match by position (name prefix, word start, anywhere else)
+ * @param entry
+ * @param term folded search term
+ * @return
+ */
+int LauncherIndex::rank( const LauncherEntry &entry, const QString &term ) {
+    int position;
+
+    if ( entry.name.startsWith( term ))
+        return 0;
+
+    for ( position = entry.name.indexOf( term ); position > 0; position = entry.name.indexOf( term, position + 1 )) {
+        if ( !entry.name.at( position - 1 ).isLetterOrNumber())
+            return 1;
+    }
+
+    return 2;
+}
+
+/**
+ * @brief LauncherIndex::find returns best matches of all (space separated) terms
+ * @param text
+ * @param limit
+ * @return
+ */
+QList<LauncherEntry> LauncherIndex::find( const QString &text, int limit ) {
+    const QStringList terms( text.toCaseFolded().split( ' ', QString::SkipEmptyParts ));
+    QVector<LauncherMatch> matches;
+    QList<LauncherEntry> list;
+    QString longest;
+    int y;
+
+    if ( terms.isEmpty())
+        return list;
+
+    // the longest term has the most selective trigrams, others are just verified
+    foreach ( const QString &term, terms ) {
+        if ( term.length() > longest.length())
+            longest = term;
+    }
+
+    this->searchIndex.setQuery( longest );
+    foreach ( quintptr id, this->searchIndex.matchedIds()) {
+        const LauncherEntry &entry( this->entries.at( static_cast<int>( id )));
+        LauncherMatch match;
+        bool accepted = true;
+
+        foreach ( const QString &term, terms ) {
+            if ( !entry.name.contains( term )) {
+                accepted = false;
+                break;
+            }
+        }
+
+        if ( !accepted )
+            continue;
+
+        match.slot = static_cast<int>( id );
+        match.rank = LauncherIndex::rank( entry, terms.first());
+        match.hits = this->frequency.value( entry.path );
+        match.length = entry.name.length();
+        matches << match;
+    }
+
+    // only the best ones are sorted
+    limit = qMin( limit, matches.count());
+    std::partial_sort( matches.begin(), matches.begin() + limit, matches.end(), [ this ]( const LauncherMatch &left, const LauncherMatch &right ) {
+        if ( left.rank != right.rank )
+            return left.rank < right.rank;
+
+        if ( left.hits != right.hits )
+            return left.hits > right.hits;
+
+        if ( left.length != right.length )
+            return left.length < right.length;
+
+        return this->entries.at( left.slot ).path < this->entries.at( right.slot ).path;
+    } );
+
+    for ( y = 0; y < limit; y++ )
+        list << this->entries.at( matches.at( y ).slot );
+
+    return list;
+}
+
+/**
+ * @brief LauncherIndex::launch opens the file and counts the launch for ranking
+ * @param path
+ */
+void LauncherIndex::launch( const QString &path ) {
+    this->frequency[path]++;
+    QDesktopServices::openUrl( QUrl::fromLocalFile( path ));
+}
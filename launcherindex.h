@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+#include "filestream.h"
+#include "searchindex.h"
+
+/**
+ * @brief The LauncherIndexNamespace namespace
+ */
+namespace LauncherIndexNamespace {
+static const quint8 Version = 1;
+static const QString IndexFilename( "launcher.index" );
+static const int MaximumDepth = 2;
+static const int MaximumEntries = 200000;
+static const int MaximumResults = 32;
+}
+
+/**
+ * @brief The LauncherEntry struct (indexed file, its folded name is used for ranking)
+ */
+struct LauncherEntry {
+    explicit LauncherEntry( const QString &p = QString(), bool d = false ) : path( p ), name( p.mid( p.lastIndexOf( '/' ) + 1 ).toCaseFolded()), directory( d ) {}
+    bool isValid() const { return !this->path.isEmpty(); }
+    QString path;
+    QString name;
+    bool directory;
+};
+
+/**
+ * @brief The LauncherScan struct (results of a background root scan)
+ */
+struct LauncherScan {
+    QString root;
+    QStringList paths;
+    QList<bool> directories;
+    QHash<QString, QDateTime> modified;
+};
+
+/**
+ * @brief The LauncherIndex class searchable index of files under all widget and desktop icon roots
+ *
+ * NOTE: roots and their contents (down to MaximumDepth) are persisted, so the launcher can be used
+ *       right away on startup, roots are then rescanned in background once and kept up to date by
+ *       the filesystem watcher (on other platforms directories whose modification time changed are
+ *       listed again whenever the launcher is opened);
+ *       results are ranked by match position (name prefix, word start, anywhere) and then by how
+ *       often the file was launched before
+ */
+class LauncherIndex final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( LauncherIndex )
+
+public:
+    static LauncherIndex *instance() { static LauncherIndex *instance( new LauncherIndex()); return instance; }
+    ~LauncherIndex() {}
+    int count() const { return this->slotForPath.count(); }
+    QStringList roots() const { return this->m_roots; }
+    bool isScanning() const { return this->scanWatcher.isRunning() || !this->pendingRoots.isEmpty(); }
+    QList<LauncherEntry> find( const QString &text, int limit = LauncherIndexNamespace::MaximumResults );
+
+signals:
+    void updated();
+
+public slots:
+    void update();
+    void launch( const QString &path );
+    void shutdown();
+
+private slots:
+    void scanFinished();
+    void directoryChanged( const QString &path, const QSet<QString> &names );
+    void directoryLost( const QString &path );
+
+private:
+    explicit LauncherIndex( QObject *parent = nullptr );
+    static LauncherScan scan( const QString &root );
+    static int rank( const LauncherEntry &entry, const QString &term );
+    bool read();
+    void write();
+    void scanNext();
+    void insert( const QString &path, bool directory );
+    void remove( const QString &path );
+    void detach( const QString &path );
+    void refresh( const QString &path, const QSet<QString> &names = QSet<QString>());
+    int depth( const QString &path, const QString &excludedRoot = QString()) const;
+    void watch( const QString &path );
+    void unwatch( const QString &path );
+    FileStream indexFile;
+    QVector<LauncherEntry> entries;
+    QVector<int> freeSlots;
+    QHash<QString, int> slotForPath;
+    QHash<QString, QSet<QString> > children;
+    QHash<QString, int> frequency;
+    SearchIndex searchIndex;
+    QStringList m_roots;
+    QStringList pendingRoots;
+    QSet<QString> watched;
+    QHash<QString, QDateTime> modified;
+    QSet<QString> scannedRoots;
+    QFutureWatcher<LauncherScan> scanWatcher;
+    bool m_valid;
+};
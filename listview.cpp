@@ -20,21 +20,32 @@
 // includes
 //
 #include <QDebug>
+#include "folderdelegate.h"
 #include "folderview.h"
 #include "iconcache.h"
 #include "listview.h"
+#include <QDrag>
 #include <QFileSystemModel>
 #include <QMenu>
 #include <QMimeData>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QRubberBand>
+#include <QScrollBar>
 
 /**
  * @brief ListView::ListView
  */
-ListView::ListView( QWidget *parent ) : QListView( parent ) {
+ListView::ListView( QWidget *parent ) : QListView( parent ), m_firstVisible( -1 ), m_lastVisible( -1 ), m_fixedGrid( false ), m_cellSize( 1, 1 ) {
     this->setSelectionMode( QAbstractItemView::SingleSelection );
     this->setSelectionRectVisible( false );
     this->proxyStyle = new ProxyStyle( this->style());
     this->setStyle( this->proxyStyle );
+
+    // recalculate visible range once per event loop pass (scrolling fires repeatedly)
+    this->rangeTimer.setSingleShot( true );
+    this->rangeTimer.setInterval( 0 );
+    this->connect( &this->rangeTimer, SIGNAL( timeout()), this, SLOT( updateVisibleRange()));
 }
 
 /**
@@ -60,6 +71,656 @@ void ListView::setReadOnly( bool enable ) {
     this->setDefaultDropAction( Qt::IgnoreAction );
 }
 
+/**
+ * @brief ListView::setFixedGrid enables fixed cell layout in icon mode
+ * @param enable
+ */
+void ListView::setFixedGrid( bool enable ) {
+    if ( enable == this->m_fixedGrid )
+        return;
+
+    this->m_fixedGrid = enable;
+
+    // items cannot be moved freely in a fixed grid
+    if ( enable )
+        this->setMovement( QListView::Static );
+
+    this->scheduleDelayedItemsLayout();
+}
+
+/**
+ * @brief ListView::updateCellSize derives cell size from the delegate (icon size, text lines
+ * and margins)
+ */
+void ListView::updateCellSize() {
+    const FolderDelegate *delegate( dynamic_cast<FolderDelegate*>( this->itemDelegate()));
+    const QStyleOptionViewItem option( this->viewOptions());
+
+    if ( delegate != nullptr )
+        this->m_cellSize = delegate->cellSize( option );
+    else
+        this->m_cellSize = QSize( option.decorationSize.width(), option.decorationSize.height() + option.fontMetrics.height());
+
+    // items are centered in grid cells, but cannot grow beyond them
+    if ( this->gridSize().isValid())
+        this->m_cellSize = this->m_cellSize.boundedTo( this->gridSize());
+
+    this->m_cellSize = this->m_cellSize.expandedTo( QSize( 1, 1 ));
+}
+
+/**
+ * @brief ListView::cellPitch returns the distance between neighbouring cells (grid size if set,
+ * spacing is then ignored like in QListView)
+ * @return
+ */
+QSize ListView::cellPitch() const {
+    if ( this->gridSize().isValid())
+        return this->gridSize().expandedTo( QSize( 1, 1 ));
+
+    return this->m_cellSize + QSize( this->spacing(), this->spacing());
+}
+
+/**
+ * @brief ListView::cellsPerLine
+ * @return
+ */
+int ListView::cellsPerLine() const {
+    return qMax( 1, ( this->viewport()->width() - this->cellMargin()) / this->cellPitch().width());
+}
+
+/**
+ * @brief ListView::rowsInRect returns the range of rows on lines intersecting a viewport rectangle
+ * (last is less than first if there are none)
+ * @param rect
+ * @param first
+ * @param last
+ */
+void ListView::rowsInRect( const QRect &rect, int &first, int &last ) const {
+    const int lineHeight = this->cellPitch().height();
+    const int columns = this->cellsPerLine();
+    const int top = qMax( 0, ( rect.top() + this->verticalOffset() - this->cellMargin()) / lineHeight );
+    const int bottom = qMax( 0, ( rect.bottom() + this->verticalOffset() - this->cellMargin()) / lineHeight );
+
+    first = top * columns;
+    last = qMin( this->itemCount() - 1, ( bottom + 1 ) * columns - 1 );
+}
+
+/**
+ * @brief ListView::visualRect
+ * @param index
+ * @return
+ */
+QRect ListView::visualRect( const QModelIndex &index ) const {
+    QSize pitch;
+    QRect rect;
+    int columns;
+
+    if ( !this->isGridActive())
+        return QListView::visualRect( index );
+
+    if ( !index.isValid() || index.parent() != this->rootIndex())
+        return QRect();
+
+    pitch = this->cellPitch();
+    columns = this->cellsPerLine();
+    rect = QRect( this->cellMargin() + this->cellInset() + ( index.row() % columns ) * pitch.width() - this->horizontalOffset(),
+                  this->cellMargin() + ( index.row() / columns ) * pitch.height() - this->verticalOffset(),
+                  this->m_cellSize.width(), this->m_cellSize.height());
+
+    // mirrored layouts flow from the right edge
+    if ( this->isRightToLeft())
+        rect.moveLeft( this->viewport()->width() - rect.right() - 1 );
+
+    return rect;
+}
+
+/**
+ * @brief ListView::indexAt
+ * @param point
+ * @return
+ */
+QModelIndex ListView::indexAt( const QPoint &point ) const {
+    QSize pitch;
+    int x, y, column, row, inset;
+
+    if ( !this->isGridActive())
+        return QListView::indexAt( point );
+
+    // mirrored layouts flow from the right edge
+    x = ( this->isRightToLeft() ? this->viewport()->width() - 1 - point.x() : point.x()) + this->horizontalOffset() - this->cellMargin();
+    y = point.y() + this->verticalOffset() - this->cellMargin();
+    if ( x < 0 || y < 0 )
+        return QModelIndex();
+
+    // spacing (or grid) around items does not belong to any of them
+    pitch = this->cellPitch();
+    inset = this->cellInset();
+    column = x / pitch.width();
+    if ( column >= this->cellsPerLine() || x % pitch.width() < inset || x % pitch.width() >= inset + this->m_cellSize.width() || y % pitch.height() >= this->m_cellSize.height())
+        return QModelIndex();
+
+    row = ( y / pitch.height()) * this->cellsPerLine() + column;
+    if ( row >= this->itemCount())
+        return QModelIndex();
+
+    return this->model()->index( row, 0, this->rootIndex());
+}
+
+/**
+ * @brief ListView::scrollTo
+ * @param index
+ * @param hint
+ */
+void ListView::scrollTo( const QModelIndex &index, ScrollHint hint ) {
+    const QRect area( this->viewport()->rect());
+    QRect rect;
+    int value;
+
+    if ( !this->isGridActive()) {
+        QListView::scrollTo( index, hint );
+        return;
+    }
+
+    rect = this->visualRect( index );
+    if ( !rect.isValid())
+        return;
+
+    value = this->verticalScrollBar()->value();
+    switch ( hint ) {
+    case EnsureVisible:
+        if ( rect.top() < area.top())
+            value += rect.top() - area.top();
+        else if ( rect.bottom() > area.bottom())
+            value += qMin( rect.bottom() - area.bottom(), rect.top() - area.top());
+        break;
+
+    case PositionAtTop:
+        value += rect.top() - area.top();
+        break;
+
+    case PositionAtBottom:
+        value += rect.bottom() - area.bottom();
+        break;
+
+    case PositionAtCenter:
+        value += rect.center().y() - area.center().y();
+        break;
+    }
+
+    this->verticalScrollBar()->setValue( value );
+}
+
+/**
+ * @brief ListView::doItemsLayout fixed grid layout only depends on the cell size and item count
+ */
+void ListView::doItemsLayout() {
+    if ( !this->isGridActive()) {
+        QListView::doItemsLayout();
+        return;
+    }
+
+    // switching to icon mode makes items movable again
+    if ( this->movement() != QListView::Static )
+        this->setMovement( QListView::Static );
+
+    this->updateCellSize();
+    QAbstractItemView::doItemsLayout();
+}
+
+/**
+ * @brief ListView::horizontalOffset
+ * @return
+ */
+int ListView::horizontalOffset() const {
+    if ( !this->isGridActive())
+        return QListView::horizontalOffset();
+
+    // lines wrap at the viewport width
+    return 0;
+}
+
+/**
+ * @brief ListView::verticalOffset
+ * @return
+ */
+int ListView::verticalOffset() const {
+    if ( !this->isGridActive())
+        return QListView::verticalOffset();
+
+    return this->verticalScrollBar()->value();
+}
+
+/**
+ * @brief ListView::moveCursor
+ * @param cursorAction
+ * @param modifiers
+ * @return
+ */
+QModelIndex ListView::moveCursor( CursorAction cursorAction, Qt::KeyboardModifiers modifiers ) {
+    int count, columns, lines, row;
+
+    if ( !this->isGridActive())
+        return QListView::moveCursor( cursorAction, modifiers );
+
+    count = this->itemCount();
+    if ( !count )
+        return QModelIndex();
+
+    if ( !this->currentIndex().isValid())
+        return this->model()->index( 0, 0, this->rootIndex());
+
+    columns = this->cellsPerLine();
+    lines = qMax( 1, this->viewport()->height() / this->cellPitch().height());
+    row = this->currentIndex().row();
+
+    // mirrored layouts, left moves forward
+    if ( this->isRightToLeft()) {
+        if ( cursorAction == MoveLeft )
+            cursorAction = MoveRight;
+        else if ( cursorAction == MoveRight )
+            cursorAction = MoveLeft;
+    }
+
+    switch ( cursorAction ) {
+    case MoveLeft:
+    case MovePrevious:
+        row--;
+        break;
+
+    case MoveRight:
+    case MoveNext:
+        row++;
+        break;
+
+    case MoveUp:
+        if ( row - columns >= 0 )
+            row -= columns;
+        break;
+
+    case MoveDown:
+        if ( row + columns < count )
+            row += columns;
+        break;
+
+    case MovePageUp:
+        row -= columns * lines;
+        break;
+
+    case MovePageDown:
+        row += columns * lines;
+        break;
+
+    case MoveHome:
+        row = 0;
+        break;
+
+    case MoveEnd:
+        row = count - 1;
+        break;
+    }
+
+    return this->model()->index( qBound( 0, row, count - 1 ), 0, this->rootIndex());
+}
+
+/**
+ * @brief ListView::setSelection selects items in a viewport rectangle (only lines in the
+ * rectangle are checked)
+ * @param rect
+ * @param command
+ */
+void ListView::setSelection( const QRect &rect, QItemSelectionModel::SelectionFlags command ) {
+    const QRect area( rect.normalized());
+    QItemSelection selection;
+    int y, first, last;
+
+    if ( !this->isGridActive()) {
+        QListView::setSelection( rect, command );
+        return;
+    }
+
+    // track the rubber band like QListView does (in content coordinates, it follows scrolling)
+    if ( this->state() == DragSelectingState && this->isSelectionRectVisible() && this->selectionMode() != SingleSelection && this->selectionMode() != NoSelection ) {
+        const QRect band( area.translated( this->horizontalOffset(), this->verticalOffset()));
+
+        this->viewport()->update( band.united( this->m_rubberBand ).translated( -this->horizontalOffset(), -this->verticalOffset()));
+        this->m_rubberBand = band;
+    }
+
+    this->rowsInRect( area, first, last );
+    for ( y = first; y <= last; y++ ) {
+        const QModelIndex index( this->model()->index( y, 0, this->rootIndex()));
+
+        if ( this->visualRect( index ).intersects( area ))
+            selection.select( index, index );
+    }
+
+    this->selectionModel()->select( selection, command );
+}
+
+/**
+ * @brief ListView::visualRegionForSelection only visible lines are included
+ * @param selection
+ * @return
+ */
+QRegion ListView::visualRegionForSelection( const QItemSelection &selection ) const {
+    QRegion region;
+    int y, first, last;
+
+    if ( !this->isGridActive())
+        return QListView::visualRegionForSelection( selection );
+
+    this->rowsInRect( this->viewport()->rect(), first, last );
+    foreach ( const QItemSelectionRange &range, selection ) {
+        if ( range.parent() != this->rootIndex())
+            continue;
+
+        for ( y = qMax( first, range.top()); y <= qMin( last, range.bottom()); y++ )
+            region += this->visualRect( this->model()->index( y, 0, this->rootIndex()));
+    }
+
+    return region;
+}
+
+/**
+ * @brief ListView::paintEvent paints only the items on lines intersecting the exposed area
+ * @param event
+ */
+void ListView::paintEvent( QPaintEvent *event ) {
+    QStyleOptionViewItem option;
+    QStyle::State state;
+    int y, first, last;
+
+    if ( !this->isGridActive()) {
+        QListView::paintEvent( event );
+        return;
+    }
+
+    QPainter painter( this->viewport());
+    const QModelIndex hover( this->viewport()->underMouse() ? this->indexAt( this->viewport()->mapFromGlobal( QCursor::pos())) : QModelIndex());
+
+    option = this->viewOptions();
+    state = option.state;
+
+    this->rowsInRect( event->rect(), first, last );
+    for ( y = first; y <= last; y++ ) {
+        const QModelIndex index( this->model()->index( y, 0, this->rootIndex()));
+
+        option.rect = this->visualRect( index );
+        if ( !option.rect.intersects( event->rect()))
+            continue;
+
+        option.state = state;
+        if ( this->selectionModel() != nullptr && this->selectionModel()->isSelected( index ))
+            option.state |= QStyle::State_Selected;
+
+        if ( index == hover )
+            option.state |= QStyle::State_MouseOver;
+
+        if ( index == this->currentIndex() && this->hasFocus())
+            option.state |= QStyle::State_HasFocus;
+
+        this->itemDelegate( index )->paint( &painter, option, index );
+    }
+
+    // rubber band, as painted by QListView
+    if ( this->m_rubberBand.isValid()) {
+        QStyleOptionRubberBand band;
+
+        band.initFrom( this );
+        band.shape = QRubberBand::Rectangle;
+        band.opaque = false;
+        band.rect = this->m_rubberBand.translated( -this->horizontalOffset(), -this->verticalOffset()).intersected( this->viewport()->rect().adjusted( -16, -16, 16, 16 ));
+        painter.save();
+        this->style()->drawControl( QStyle::CE_RubberBand, &band, &painter );
+        painter.restore();
+    }
+
+    // drop indicator, as painted by QAbstractItemView (style decides whether it is visible)
+    if ( this->showDropIndicator() && this->state() == DraggingState && this->viewport()->cursor().shape() != Qt::ForbiddenCursor ) {
+        QStyleOption indicator;
+
+        indicator.initFrom( this );
+        indicator.rect = this->m_dropIndicator;
+        this->style()->drawPrimitive( QStyle::PE_IndicatorItemViewItemDrop, &indicator, &painter, this );
+    }
+}
+
+/**
+ * @brief ListView::mouseReleaseEvent removes the rubber band
+ * @param event
+ */
+void ListView::mouseReleaseEvent( QMouseEvent *event ) {
+    QListView::mouseReleaseEvent( event );
+
+    if ( this->m_rubberBand.isValid()) {
+        this->viewport()->update( this->m_rubberBand.translated( -this->horizontalOffset(), -this->verticalOffset()));
+        this->m_rubberBand = QRect();
+    }
+}
+
+/**
+ * @brief ListView::dragMoveEvent keeps track of the drop indicator in fixed grid mode
+ * (QAbstractItemView keeps its own private, the same rectangles are derived here)
+ * @param event
+ */
+void ListView::dragMoveEvent( QDragMoveEvent *event ) {
+    QRect rect;
+
+    QListView::dragMoveEvent( event );
+
+    if ( !this->isGridActive())
+        return;
+
+    if ( this->showDropIndicator() && this->state() == DraggingState ) {
+        const QRect item( this->visualRect( this->indexAt( event->pos())));
+
+        switch ( this->dropIndicatorPosition()) {
+        case AboveItem:
+            rect = QRect( item.left(), item.top(), item.width(), 0 );
+            break;
+
+        case BelowItem:
+            rect = QRect( item.left(), item.bottom(), item.width(), 0 );
+            break;
+
+        case OnItem:
+            rect = item;
+            break;
+
+        case OnViewport:
+            break;
+        }
+    }
+
+    if ( rect != this->m_dropIndicator ) {
+        this->m_dropIndicator = rect;
+        this->viewport()->update();
+    }
+}
+
+/**
+ * @brief ListView::dragLeaveEvent
+ * @param event
+ */
+void ListView::dragLeaveEvent( QDragLeaveEvent *event ) {
+    QListView::dragLeaveEvent( event );
+
+    this->m_dropIndicator = QRect();
+    this->viewport()->update();
+}
+
+/**
+ * @brief ListView::startDrag in fixed grid mode the drag pixmap is painted from grid geometry
+ * (QListView paints the items found in its own layout, which is empty here)
+ * @param supportedActions
+ */
+void ListView::startDrag( Qt::DropActions supportedActions ) {
+    QModelIndexList indexes;
+    QStyleOptionViewItem option;
+    Qt::DropAction defaultAction = Qt::IgnoreAction;
+    QMimeData *data;
+    QDrag *drag;
+    QRect rect;
+
+    if ( !this->isGridActive()) {
+        QListView::startDrag( supportedActions );
+        return;
+    }
+
+    foreach ( const QModelIndex &index, this->selectedIndexes()) {
+        if ( this->model()->flags( index ) & Qt::ItemIsDragEnabled )
+            indexes << index;
+    }
+
+    if ( indexes.isEmpty())
+        return;
+
+    data = this->model()->mimeData( indexes );
+    if ( data == nullptr )
+        return;
+
+    // only the visible part of the selection is painted (as in QListView)
+    foreach ( const QModelIndex &index, indexes )
+        rect |= this->visualRect( index ).intersected( this->viewport()->rect());
+
+    drag = new QDrag( this );
+    drag->setMimeData( data );
+
+    if ( rect.isValid()) {
+        QPixmap pixmap( rect.size() * this->devicePixelRatioF());
+
+        pixmap.setDevicePixelRatio( this->devicePixelRatioF());
+        pixmap.fill( Qt::transparent );
+        {
+            QPainter painter( &pixmap );
+
+            option = this->viewOptions();
+            option.state |= QStyle::State_Selected;
+
+            foreach ( const QModelIndex &index, indexes ) {
+                option.rect = this->visualRect( index );
+                if ( !option.rect.intersects( rect ))
+                    continue;
+
+                option.rect.translate( -rect.topLeft());
+                this->itemDelegate( index )->paint( &painter, option, index );
+            }
+        }
+
+        drag->setPixmap( pixmap );
+        drag->setHotSpot( this->viewport()->mapFromGlobal( QCursor::pos()) - rect.topLeft());
+    }
+
+    // same default action as QAbstractItemView
+    if ( this->defaultDropAction() != Qt::IgnoreAction && ( supportedActions & this->defaultDropAction()))
+        defaultAction = this->defaultDropAction();
+    else if (( supportedActions & Qt::CopyAction ) && this->dragDropMode() != QAbstractItemView::InternalMove )
+        defaultAction = Qt::CopyAction;
+
+    // files are moved by the drop target, the source model has no rows to remove
+    drag->exec( supportedActions, defaultAction );
+}
+
+/**
+ * @brief ListView::keyboardSearch typed text starts filtering instead of jumping to a match
+ * @param search
+ */
+void ListView::keyboardSearch( const QString &search ) {
+    if ( this->receivers( SIGNAL( searchRequested( QString ))) == 0 ) {
+        QListView::keyboardSearch( search );
+        return;
+    }
+
+    emit this->searchRequested( search );
+}
+
+/**
+ * @brief ListView::scrollContentsBy
+ * @param dx
+ * @param dy
+ */
+void ListView::scrollContentsBy( int dx, int dy ) {
+    QListView::scrollContentsBy( dx, dy );
+    this->rangeTimer.start();
+}
+
+/**
+ * @brief ListView::updateGeometries called after layouts and resizes
+ */
+void ListView::updateGeometries() {
+    int columns, lines;
+
+    if ( !this->isGridActive()) {
+        QListView::updateGeometries();
+        this->rangeTimer.start();
+        return;
+    }
+
+    // content height follows from the item count alone
+    columns = this->cellsPerLine();
+    lines = ( this->itemCount() + columns - 1 ) / columns;
+
+    this->horizontalScrollBar()->setRange( 0, 0 );
+    this->verticalScrollBar()->setSingleStep( qMax( 1, this->m_cellSize.height() / 2 ));
+    this->verticalScrollBar()->setPageStep( this->viewport()->height());
+    this->verticalScrollBar()->setRange( 0, qMax( 0, this->cellMargin() + lines * this->cellPitch().height() - this->viewport()->height()));
+
+    QAbstractItemView::updateGeometries();
+    this->rangeTimer.start();
+}
+
+/**
+ * @brief ListView::updateVisibleRange finds the first and last row under the viewport
+ * (computed directly in fixed grid mode, otherwise items are laid out in row order, so
+ * probing from both corners is enough)
+ */
+void ListView::updateVisibleRange() {
+    const QRect rect( this->viewport()->rect());
+    const int step = qMax( 8, this->iconSize().width() / 2 );
+    int x, y, first = -1, last = -1;
+
+    // rows follow from the grid geometry
+    if ( this->isGridActive()) {
+        this->rowsInRect( rect, first, last );
+        if ( last < first )
+            first = last = -1;
+    } else {
+        // first row, probe from the top left corner
+        for ( y = rect.top(); y <= rect.bottom() && first < 0; y += step ) {
+            for ( x = rect.left(); x <= rect.right(); x += step ) {
+                const QModelIndex index( this->indexAt( QPoint( x, y )));
+
+                if ( index.isValid()) {
+                    first = index.row();
+                    break;
+                }
+            }
+        }
+
+        // last row, probe from the bottom right corner
+        for ( y = rect.bottom(); y >= rect.top() && last < 0 && first >= 0; y -= step ) {
+            for ( x = rect.right(); x >= rect.left(); x -= step ) {
+                const QModelIndex index( this->indexAt( QPoint( x, y )));
+
+                if ( index.isValid()) {
+                    last = index.row();
+                    break;
+                }
+            }
+        }
+    }
+
+    if ( first > last )
+        qSwap( first, last );
+
+    if ( first == this->m_firstVisible && last == this->m_lastVisible )
+        return;
+
+    this->m_firstVisible = first;
+    this->m_lastVisible = last;
+    emit this->visibleRangeChanged( first, last );
+}
+
 /**
  * @brief ListView::dropEvent
  * @param event
@@ -67,6 +728,9 @@ void ListView::setReadOnly( bool enable ) {
 void ListView::dropEvent( QDropEvent *event ) {
     QMenu menu;
 
+    // drop ends the drag
+    this->m_dropIndicator = QRect();
+
     // abort if same source
     // TODO: allow dropping on internal folders
     if ( event->source() == qobject_cast<QObject*>( this ))
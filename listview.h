@@ -25,6 +25,7 @@
 #include <QWidget>
 #include <QDropEvent>
 #include <QProxyStyle>
+#include <QTimer>
 
 /**
  * @brief The ProxyStyle class
@@ -40,6 +41,11 @@ public:
 
 /**
  * @brief The ListView class
+ *
+ * NOTE: in fixed grid mode (icon mode only) all items share one cell size derived from the
+ *       delegate, so geometry is computed from the row number alone and QListView's per item
+ *       layout is bypassed; as in QListView, gridSize() (if set) replaces cell size and spacing
+ *       as the distance between items and right to left layouts are mirrored
  */
 class ListView : public QListView {
     Q_OBJECT
@@ -48,12 +54,55 @@ public:
     explicit ListView( QWidget *parent = nullptr );
     ~ListView();
 
+    int firstVisibleRow() const { return this->m_firstVisible; }
+    int lastVisibleRow() const { return this->m_lastVisible; }
+    bool isFixedGrid() const { return this->m_fixedGrid; }
+    QSize cellSize() const { return this->m_cellSize; }
+    QRect visualRect( const QModelIndex &index ) const;
+    QModelIndex indexAt( const QPoint &point ) const;
+    void scrollTo( const QModelIndex &index, ScrollHint hint = EnsureVisible );
+    void doItemsLayout();
+    void keyboardSearch( const QString &search );
+
 public slots:
     void setReadOnly( bool enable );
+    void setFixedGrid( bool enable );
+    void updateVisibleRange();
+
+signals:
+    void visibleRangeChanged( int first, int last );
+    void searchRequested( const QString &text );
 
 protected:
     void dropEvent( QDropEvent *event );
+    void dragMoveEvent( QDragMoveEvent *event );
+    void dragLeaveEvent( QDragLeaveEvent *event );
+    void startDrag( Qt::DropActions supportedActions );
+    void mouseReleaseEvent( QMouseEvent *event );
+    void scrollContentsBy( int dx, int dy );
+    void updateGeometries();
+    void paintEvent( QPaintEvent *event );
+    int horizontalOffset() const;
+    int verticalOffset() const;
+    QModelIndex moveCursor( CursorAction cursorAction, Qt::KeyboardModifiers modifiers );
+    void setSelection( const QRect &rect, QItemSelectionModel::SelectionFlags command );
+    QRegion visualRegionForSelection( const QItemSelection &selection ) const;
 
 private:
+    bool isGridActive() const { return this->m_fixedGrid && this->viewMode() == QListView::IconMode && this->model() != nullptr; }
+    int itemCount() const { return this->model()->rowCount( this->rootIndex()); }
+    QSize cellPitch() const;
+    int cellMargin() const { return this->gridSize().isValid() ? 0 : this->spacing(); }
+    int cellInset() const { return ( this->cellPitch().width() - this->cellMargin() - this->m_cellSize.width()) / 2; }
+    int cellsPerLine() const;
+    void rowsInRect( const QRect &rect, int &first, int &last ) const;
+    void updateCellSize();
     ProxyStyle *proxyStyle;
+    QTimer rangeTimer;
+    int m_firstVisible;
+    int m_lastVisible;
+    bool m_fixedGrid;
+    QSize m_cellSize;
+    QRect m_rubberBand;
+    QRect m_dropIndicator;
 };
@@ -23,7 +23,14 @@
 #include "widgetlist.h"
 #include "iconindex.h"
 #include "iconcache.h"
+#include "iconscheduler.h"
 #include "indexcache.h"
+#include "mimecache.h"
+#include "modelregistry.h"
+#include "launcherindex.h"
+#ifdef Q_OS_LINUX
+#include "filewatcher.h"
+#endif
 #include "variable.h"
 #include "proxymodel.h"
 #include "application.h"
@@ -190,6 +197,7 @@ int main( int argc, char *argv[] ) {
     qRegisterMetaType<MatchList>( "MatchList" );
     qRegisterMetaType<Theme*>( "Theme*" );
     qRegisterMetaType<ProxyIcon>( "ProxyIcon" );
+    qRegisterMetaType<FileMeta>( "FileMeta" );
 
     // add default variables
     Variable::instance()->add( "ui_displaySymlinkIcon", true );
@@ -202,6 +210,9 @@ int main( int argc, char *argv[] ) {
     XMLTools::instance()->read( XMLTools::Themes );
     Variable::instance()->bind( "app_lock", XMLTools::instance(), SLOT( saveOnLock( QVariant )));
 
+    // read mime cache before any icon workers are started
+    MimeCache::instance();
+
     // request a trivial icon early to avoid QObject::moveToThread bug
 #ifdef Q_OS_LINUX
     QIcon i;
@@ -290,6 +301,9 @@ void Main::readConfiguration() {
     XMLTools::instance()->read( XMLTools::Widgets );
     this->widgetList->reset();
 
+    // index files of all widgets for the quick launcher
+    LauncherIndex::instance()->update();
+
     // all done
     if ( !FolderManager::instance()->count() && !FolderManager::instance()->iconCount())
         this->widgetList->show();
@@ -361,12 +375,19 @@ void Main::shutdown() {
     this->setInitialized( false );
 
     // close all subsystems
+    IconScheduler::instance()->shutdown();
     IndexCache::instance()->shutdown();
+    MimeCache::instance()->shutdown();
     IconCache::instance()->shutdown();
     IconIndex::instance()->shutdown();
     Themes::instance()->shutdown();
     FolderManager::instance()->shutdown();
     delete this->widgetList;
+    LauncherIndex::instance()->shutdown();
+    ModelRegistry::instance()->shutdown();
+#ifdef Q_OS_LINUX
+    FileWatcher::instance()->shutdown();
+#endif
 
     // close all windows
     qApp->closeAllWindows();
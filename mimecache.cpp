@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDebug>
+#include <QFileInfo>
+#include <QDateTime>
+#include "mimecache.h"
+#include "indexcache.h"
+#include "main.h"
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief MimeCache::MimeCache
+ * @param parent
+ */
+MimeCache::MimeCache( QObject *parent ) : QObject( parent ), m_valid( false ), m_staleEntries( 0 ), m_sniffCount( 0 ) {
+    // announce
+#ifdef QT_DEBUG
+    qInfo() << this->tr( "initializing" );
+#endif
+
+    // set up index file next to the icon index
+    this->indexFile.setFilename( IndexCache::instance()->path() + "/" + MimeCacheNamespace::IndexFilename );
+    if ( !this->indexFile.open()) {
+        qCritical() << this->tr( "mime index file non-writable" );
+    } else {
+        if ( !this->indexFile.size())
+            this->indexFile << MimeCacheNamespace::Version;
+
+        // a bad index is not fatal, just start over
+        if ( !this->read()) {
+            this->indexFile.clear();
+            this->indexFile.toStart();
+            this->indexFile << MimeCacheNamespace::Version;
+        }
+
+        this->m_valid = true;
+    }
+
+    // add to garbage collector
+    GarbageMan::instance()->add( this );
+}
+
+/**
+ * @brief MimeCache::read
+ * @return
+ */
+bool MimeCache::read() {
+    quint8 version;
+    MimeEntry entry;
+    int count = 0;
+
+    // read index file version
+    this->indexFile.toStart();
+    this->indexFile >> version;
+
+    // check version
+    if ( version != MimeCacheNamespace::Version ) {
+        qCritical() << this->tr( "version mismatch for mime index file" );
+        return false;
+    }
+
+    // read entries (later entries override earlier ones)
+    while ( !this->indexFile.atEnd()) {
+        this->indexFile >> entry;
+        if ( this->indexFile.status() != QDataStream::Ok )
+            break;
+
+        this->index[entry.key] = entry;
+        count++;
+    }
+    this->m_staleEntries = count - this->index.count();
+
+    // truncated tail, rewrite the file on shutdown
+    if ( this->indexFile.status() != QDataStream::Ok ) {
+        this->indexFile.resetStatus();
+        this->m_staleEntries = MimeCacheNamespace::CompactThreshold;
+    }
+
+    // report
+    qInfo() << this->tr( "found %1 entries in mime index file" ).arg( this->index.count());
+
+    // return success
+    return true;
+}
+
+/**
+ * @brief MimeCache::write appends a single entry to the index file
+ * @param entry
+ */
+void MimeCache::write( const MimeEntry &entry ) {
+    if ( !this->m_valid )
+        return;
+
+    this->indexFile.seek( FileStream::End );
+    this->indexFile << entry;
+}
+
+/**
+ * @brief MimeCache::compact rewrites the index file without superseded entries
+ */
+void MimeCache::compact() {
+    QHash<MimeKey, MimeEntry>::const_iterator i;
+
+    this->indexFile.clear();
+    this->indexFile.toStart();
+    this->indexFile << MimeCacheNamespace::Version;
+
+    for ( i = this->index.constBegin(); i != this->index.constEnd(); ++i )
+        this->indexFile << i.value();
+
+    this->m_staleEntries = 0;
+}
+
+/**
+ * @brief MimeCache::shutdown
+ */
+void MimeCache::shutdown() {
+    QMutexLocker lock( &this->mutex );
+
+    if ( !this->m_valid )
+        return;
+
+    // drop superseded entries if there are too many of them
+    if ( this->m_staleEntries >= MimeCacheNamespace::CompactThreshold ) {
+        qInfo() << this->tr( "compacting mime index file" );
+        this->compact();
+    }
+
+    // set subsystem as inactive and close the index file
+    this->m_valid = false;
+    this->indexFile.close();
+}
+
+/**
+ * @brief MimeCache::statFile
+ * @param fileName
+ * @return
+ */
+MimeEntry MimeCache::statFile( const QString &fileName ) {
+#ifdef Q_OS_UNIX
+    struct stat buffer;
+
+    if ( ::stat( QFile::encodeName( fileName ).constData(), &buffer ) != 0 )
+        return MimeEntry();
+
+    return MimeEntry( MimeKey( static_cast<quint64>( buffer.st_dev ), static_cast<quint64>( buffer.st_ino )), static_cast<qint64>( buffer.st_mtime ));
+#else
+    // no inodes here, use the same path id as FileMeta
+    const QFileInfo info( fileName );
+
+    if ( !info.exists())
+        return MimeEntry();
+
+    return MimeEntry( MimeKey( 0, FileMeta::pathId( info.absoluteFilePath(), info.size())), info.lastModified().toMSecsSinceEpoch() / 1000 );
+#endif
+}
+
+/**
+ * @brief MimeCache::mimeType
+ * @param fileName
+ * @return
+ */
+QMimeType MimeCache::mimeType( const QString &fileName ) {
+    // unambiguous glob match requires no file access at all
+    const QList<QMimeType> globMatches( this->db.mimeTypesForFileName( fileName ));
+    if ( globMatches.count() == 1 )
+        return globMatches.first();
+
+    return this->lookup( fileName, MimeCache::statFile( fileName ));
+}
+
+/**
+ * @brief MimeCache::mimeType same as above, but uses metadata already collected by the model
+ * (stats the file only if the inode is not known)
+ * @param meta
+ * @return
+ */
+QMimeType MimeCache::mimeType( const FileMeta &meta ) {
+    const QString fileName( meta.absolutePath());
+    const QList<QMimeType> globMatches( this->db.mimeTypesForFileName( fileName ));
+    if ( globMatches.count() == 1 )
+        return globMatches.first();
+
+    if ( meta.inode && !meta.isSymLink())
+        return this->lookup( fileName, MimeEntry( MimeKey( meta.device, meta.inode ), meta.modified / 1000 ));
+
+    return this->lookup( fileName, MimeCache::statFile( fileName ));
+}
+
+/**
+ * @brief MimeCache::cachedMimeType same as above, but never touches the file (returns an invalid
+ * type if content sniffing would be required and there is no sniffed result for this revision)
+ * @param meta
+ * @return
+ */
+QMimeType MimeCache::cachedMimeType( const FileMeta &meta ) {
+    const QList<QMimeType> globMatches( this->db.mimeTypesForFileName( meta.absolutePath()));
+    if ( globMatches.count() == 1 )
+        return globMatches.first();
+
+    if ( meta.inode && !meta.isSymLink()) {
+        QMutexLocker lock( &this->mutex );
+        const QHash<MimeKey, MimeEntry>::const_iterator cached( this->index.constFind( MimeKey( meta.device, meta.inode )));
+
+        if ( cached != this->index.constEnd() && cached->modified == meta.modified / 1000 )
+            return this->db.mimeTypeForName( cached->mimeName );
+    }
+
+    return QMimeType();
+}
+
+/**
+ * @brief MimeCache::lookup returns a previously sniffed result or sniffs file contents
+ * @param fileName
+ * @param entry
+ * @return
+ */
+QMimeType MimeCache::lookup( const QString &fileName, MimeEntry entry ) {
+    // check for a previously sniffed result for this file revision
+    if ( entry.key.isValid()) {
+        QMutexLocker lock( &this->mutex );
+
+        if ( this->index.contains( entry.key )) {
+            const MimeEntry &cached = this->index[entry.key];
+
+            if ( cached.modified == entry.modified )
+                return this->db.mimeTypeForName( cached.mimeName );
+        }
+    }
+
+    // sniff content (this reads the file)
+    const QMimeType mimeType( this->db.mimeTypeForFile( fileName, QMimeDatabase::MatchContent ));
+    if ( entry.key.isValid() && mimeType.isValid()) {
+        QMutexLocker lock( &this->mutex );
+
+        // file was modified, previous entry is superseded
+        if ( this->index.contains( entry.key ))
+            this->m_staleEntries++;
+
+        entry.mimeName = mimeType.name();
+        this->index[entry.key] = entry;
+        this->write( entry );
+        this->m_sniffCount.ref();
+    }
+
+    return mimeType;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QMimeDatabase>
+#include <QMutex>
+#include <QAtomicInt>
+#include "filestream.h"
+#include "filemeta.h"
+
+/**
+ * @brief The MimeKey struct identifies a file (device, inode)
+ */
+struct MimeKey {
+    explicit MimeKey( quint64 d = 0, quint64 i = 0 ) : device( d ), inode( i ) {}
+    bool isValid() const { return this->inode != 0; }
+    bool operator==( const MimeKey &other ) const { return this->device == other.device && this->inode == other.inode; }
+    quint64 device;
+    quint64 inode;
+};
+inline uint qHash( const MimeKey &key, uint seed = 0 ) { return qHash( key.inode, seed ) ^ qHash( key.device ); }
+
+/**
+ * @brief The MimeEntry struct sniffed mimetype of a file revision (key and modification time in seconds)
+ */
+struct MimeEntry {
+    explicit MimeEntry( const MimeKey &k = MimeKey(), qint64 m = 0, const QString &n = QString()) : key( k ), modified( m ), mimeName( n ) {}
+    MimeKey key;
+    qint64 modified;
+    QString mimeName;
+};
+
+// read/write operators
+inline static QDataStream &operator<<( QDataStream &out, const MimeEntry &e ) { out << e.key.device << e.key.inode << e.modified << e.mimeName; return out; }
+inline static QDataStream &operator>>( QDataStream &in, MimeEntry &e ) { in >> e.key.device >> e.key.inode >> e.modified >> e.mimeName; return in; }
+
+/**
+ * @brief The MimeCacheNamespace namespace
+ */
+namespace MimeCacheNamespace {
+    static const quint8 Version = 1;
+    static const QString IndexFilename( "mime.index" );
+    static const int CompactThreshold = 1024;
+}
+
+/**
+ * @brief The MimeCache class tiered mimetype detection (glob first, content sniffing only when
+ * the glob result is ambiguous or absent) with sniffed results persisted per file revision
+ */
+class MimeCache final : public QObject {
+    Q_OBJECT
+
+public:
+    static MimeCache *instance() { static MimeCache *instance( new MimeCache()); return instance; }
+    ~MimeCache() {}
+    QMimeType mimeType( const QString &fileName );
+    QMimeType mimeType( const FileMeta &meta );
+    QMimeType cachedMimeType( const FileMeta &meta );
+    static MimeEntry statFile( const QString &fileName );
+    int sniffCount() const { return this->m_sniffCount.load(); }
+
+public slots:
+    void shutdown();
+
+private:
+    MimeCache( QObject *parent = nullptr );
+    bool read();
+    void write( const MimeEntry &entry );
+    void compact();
+    QMimeType lookup( const QString &fileName, MimeEntry entry );
+    FileStream indexFile;
+    QHash<MimeKey, MimeEntry> index;
+    QMimeDatabase db;
+    QMutex mutex;
+    bool m_valid;
+    int m_staleEntries;
+    QAtomicInt m_sniffCount;
+};
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include "filesystemmodel.h"
+#include "modelregistry.h"
+#include "main.h"
+
+/**
+ * @brief ModelRegistry::ModelRegistry
+ * @param parent
+ */
+ModelRegistry::ModelRegistry( QObject *parent ) : QObject( parent ) {
+    // announce
+#ifdef QT_DEBUG
+    qInfo() << this->tr( "initializing" );
+#endif
+
+    // add to garbage collector
+    GarbageMan::instance()->add( this );
+}
+
+/**
+ * @brief ModelRegistry::canonicalPath resolves symlinks, so that all paths to a directory share a model
+ * @param path
+ * @return
+ */
+QString ModelRegistry::canonicalPath( const QString &path ) {
+    const QString canonicalPath( QFileInfo( path ).canonicalFilePath());
+
+    // directory does not exist (yet)
+    if ( canonicalPath.isEmpty())
+        return QDir::cleanPath( QDir( path ).absolutePath());
+
+    return canonicalPath;
+}
+
+/**
+ * @brief ModelRegistry::acquire returns the shared model of a directory (created on first use)
+ * @param path
+ * @return
+ */
+FileSystemModel *ModelRegistry::acquire( const QString &path ) {
+    const QString key( ModelRegistry::canonicalPath( path ));
+    QHash<QString, ModelRegistryEntry>::iterator entry( this->models.find( key ));
+
+    if ( entry == this->models.end()) {
+        FileSystemModel *model = new FileSystemModel( nullptr, key );
+
+        // read only mode is a per view setting (drops are disabled in the view)
+        model->setReadOnly( false );
+        entry = this->models.insert( key, ModelRegistryEntry( model ));
+    }
+
+    entry->references++;
+    return entry->model;
+}
+
+/**
+ * @brief ModelRegistry::release deletes the model once no view uses it
+ * @param model
+ */
+void ModelRegistry::release( FileSystemModel *model ) {
+    QMutableHashIterator<QString, ModelRegistryEntry> i( this->models );
+
+    if ( model == nullptr )
+        return;
+
+    while ( i.hasNext()) {
+        i.next();
+
+        if ( i.value().model != model )
+            continue;
+
+        i.value().references--;
+        if ( i.value().references <= 0 ) {
+            delete i.value().model;
+            i.remove();
+        }
+        return;
+    }
+}
+
+/**
+ * @brief ModelRegistry::shutdown
+ */
+void ModelRegistry::shutdown() {
+    foreach ( const ModelRegistryEntry &entry, this->models )
+        delete entry.model;
+
+    this->models.clear();
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QObject>
+
+//
+// classes
+//
+class FileSystemModel;
+
+/**
+ * @brief The ModelRegistryEntry struct (shared source model and the number of views using it)
+ */
+struct ModelRegistryEntry {
+    explicit ModelRegistryEntry( FileSystemModel *m = nullptr ) : model( m ), references( 0 ) {}
+    FileSystemModel *model;
+    int references;
+};
+
+/**
+ * @brief The ModelRegistry class source models shared by views with the same root directory
+ * (each view keeps its own proxy model), must only be used from the GUI thread
+ */
+class ModelRegistry final : public QObject {
+    Q_OBJECT
+    Q_DISABLE_COPY( ModelRegistry )
+
+public:
+    static ModelRegistry *instance() { static ModelRegistry *instance( new ModelRegistry()); return instance; }
+    ~ModelRegistry() { this->shutdown(); }
+    static QString canonicalPath( const QString &path );
+    FileSystemModel *acquire( const QString &path );
+    void release( FileSystemModel *model );
+    int count() const { return this->models.count(); }
+
+public slots:
+    void shutdown();
+
+private:
+    explicit ModelRegistry( QObject *parent = nullptr );
+    QHash<QString, ModelRegistryEntry> models;
+};
@@ -30,92 +30,777 @@
  * @brief ProxyModel::ProxyModel
  * @param parent
  */
-ProxyModel::ProxyModel( QObject *parent ) : QSortFilterProxyModel( parent ), m_stopping( false ), threadPool( new QThreadPool( this )) {
+ProxyModel::ProxyModel( QObject *parent ) : QSortFilterProxyModel( parent ), m_nextHandle( 1 ), m_orderDirty( false ), m_firstVisible( -1 ), m_lastVisible( -1 ), m_direction( 0 ), guard( new ProxyTaskGuard( this )), m_rowsDirty( true ), m_keyCaseSensitive( false ), m_keyNumeric( false ), m_maxItems( 0 ), m_limitDirty( false ) {
+    int y;
+
+    for ( y = 0; y < ProxyRequest::StateCount; y++ )
+        this->m_stateCounts[y] = 0;
+
     this->view = qobject_cast<FolderView*>( parent );
-#ifdef ALT_PROXY_MODE
-    this->connect( this, SIGNAL( iconFound( QString, QIcon )), this, SLOT( updateModel( QString, QIcon )));
-#else
-    this->connect( this, SIGNAL( iconFound( QString, QIcon, QPersistentModelIndex )), this, SLOT( updateModel( QString, QIcon, QPersistentModelIndex )));
-#endif
+
+    // source models list hidden files, views hide them unless configured otherwise
+    this->fileFilter.setRules( FileFilterRules());
+
+    // convert worker results to icons once per frame
+    this->batchTimer.setSingleShot( true );
+    this->batchTimer.setInterval( ProxyModelNamespace::BatchInterval );
+    this->connect( &this->batchTimer, SIGNAL( timeout()), this, SLOT( processBatch()));
+
+    // submit collected requests once the view has finished asking for icons
+    this->dispatchTimer.setSingleShot( true );
+    this->dispatchTimer.setInterval( 0 );
+    this->connect( &this->dispatchTimer, SIGNAL( timeout()), this, SLOT( dispatch()));
+
+    // icon requests are run by the shared worker pool
+    IconScheduler::instance()->add( this );
 }
 
 /**
  * @brief ProxyModel::~ProxyModel
  */
 ProxyModel::~ProxyModel() {
-    this->waitForThreads();
-    delete this->threadPool;
+    IconScheduler::instance()->remove( this );
 
-#ifdef ALT_PROXY_MODE
-    this->disconnect( this, SIGNAL( iconFound( QString, QIcon )));
-#else
-    this->disconnect( this, SIGNAL( iconFound( QString, QIcon, QPersistentModelIndex )));
-#endif
+    // in-flight tasks are not waited for, they hold the guard and drop their results
+    this->cancel();
+    {
+        QWriteLocker lock( &this->guard->lock );
+        this->guard->model = nullptr;
+    }
+
+    // discard unprocessed results
+    this->takeResults();
+    this->releaseSharedIcons();
 }
 
 /**
- * @brief ProxyModel::waitForThreads
+ * @brief ProxyModel::cancel drops all pending and in-flight requests without waiting
+ * (workers notice the new generation between stages, late results are dropped on arrival)
  */
-void ProxyModel::waitForThreads() {
-    // stop receiving any pending updates
-    this->blockSignals( true );
+void ProxyModel::cancel() {
+    QMutableHashIterator<QString, ProxyRequest> i( this->requests );
+
+    this->guard->generation.ref();
 
-    // signal all active threads to stop
-    this->stop();
+    // views ask for cancelled requests again when painting
+    while ( i.hasNext()) {
+        i.next();
+
+        if ( i.value().state == ProxyRequest::Queued || i.value().state == ProxyRequest::Running )
+            this->setState( i.value(), ProxyRequest::Cancelled );
+    }
 
-    // wait for threads to finish computation and empty the thread pool
-    this->threadPool->waitForDone();
+    this->order.clear();
+    this->m_orderDirty = false;
 
-    // allow updates and new threads
-    this->blockSignals( false );
-    this->reset();
+    // files waiting for a shared icon ask again as well
+    this->pendingKeys.clear();
+    this->waiting.clear();
 }
 
 /**
- * @brief ProxyModel::updateModel
+ * @brief ProxyModel::setSharedIcon caches an icon from the shared store for a file (the store
+ * entry is held while any file of this view uses it)
  * @param fileName
+ * @param key
+ * @param modified
+ * @param symLink
+ * @return
+ */
+QIcon ProxyModel::setSharedIcon( const QString &fileName, const QString &key, qint64 modified, bool symLink ) const {
+    const QString previous( this->cache.value( fileName ).key );
+    ProxyCacheEntry entry( IconStore::instance()->icon( key ), modified, symLink );
+
+    if ( this->sharedKeys[key]++ == 0 )
+        IconStore::instance()->acquire( key );
+
+    entry.key = key;
+    this->cache[fileName] = entry;
+    this->releaseSharedIcon( previous );
+
+    return entry.icon;
+}
+
+/**
+ * @brief ProxyModel::releaseSharedIcon drops a file's reference to a shared icon
+ * @param key
+ */
+void ProxyModel::releaseSharedIcon( const QString &key ) const {
+    const QHash<QString, int>::iterator shared( this->sharedKeys.find( key ));
+
+    if ( key.isEmpty() || shared == this->sharedKeys.end())
+        return;
+
+    if ( --shared.value() <= 0 ) {
+        this->sharedKeys.erase( shared );
+        IconStore::instance()->release( key );
+    }
+}
+
+/**
+ * @brief ProxyModel::releaseSharedIcons drops references to shared icons (cached copies are
+ * still shown until replaced)
+ */
+void ProxyModel::releaseSharedIcons() {
+    QMutableHashIterator<QString, ProxyCacheEntry> i( this->cache );
+
+    foreach ( const QString &key, this->sharedKeys.keys())
+        IconStore::instance()->release( key );
+
+    this->sharedKeys.clear();
+
+    while ( i.hasNext()) {
+        i.next();
+        i.value().key.clear();
+    }
+}
+
+/**
+ * @brief ProxyModel::pushResult adds worker result to the lock-free queue (multiple producers)
  * @param icon
- * @param index
  */
+void ProxyModel::pushResult( const ProxyIcon &icon ) {
+    ProxyIconNode *node = new ProxyIconNode( icon );
+    ProxyIconNode *head;
+
+    do {
+        head = this->results.loadAcquire();
+        node->next = head;
+    } while ( !this->results.testAndSetRelease( head, node ));
+
+    // first result since the last batch, wake up the GUI thread
+    if ( head == nullptr )
+        QMetaObject::invokeMethod( this, "scheduleBatch", Qt::QueuedConnection );
+}
+
+/**
+ * @brief ProxyModel::takeResults drains the result queue (single consumer)
+ * @return
+ */
+QList<ProxyIcon> ProxyModel::takeResults() {
+    QList<ProxyIcon> list;
+    ProxyIconNode *node = this->results.fetchAndStoreAcquire( nullptr );
+
+    // nodes are stored newest first
+    while ( node != nullptr ) {
+        ProxyIconNode *next = node->next;
+
+        list.prepend( node->icon );
+        delete node;
+        node = next;
+    }
+
+    return list;
+}
+
+/**
+ * @brief ProxyModel::processBatch converts queued images to icons on the GUI thread and
+ * notifies views with merged row ranges
+ */
+void ProxyModel::processBatch() {
+    const QList<ProxyIcon> results( this->takeResults());
+    QModelIndexList changed;
+
+    foreach ( const ProxyIcon &result, results ) {
 #ifdef ALT_PROXY_MODE
-void ProxyModel::updateModel( const QString &fileName, const QIcon &icon ) {
-    int y;
-    QModelIndex index;
-    bool found = false;
+        QModelIndex index;
 #else
-void ProxyModel::updateModel( const QString &fileName, const QIcon &icon, const QPersistentModelIndex &index ) {
+        const QModelIndex index( result.index );
 #endif
+        // stale result (request was cancelled and possibly queued again since)
+        if ( this->isCancelled( result.generation ))
+            continue;
 
-    if ( icon.isNull())
-        return;
+        const QHash<QString, ProxyRequest>::iterator request( this->requests.find( result.fileName ));
+
+        // superseded result (file was modified or removed since)
+        if ( request == this->requests.end() || request->state != ProxyRequest::Running || request->handle != result.handle )
+            continue;
+
+        this->setState( *request, ProxyRequest::Done );
+
+        // icon is shared by all files of the same type or by all views of the same file
+        if ( !request->key.isEmpty()) {
+            const QString key( request->key );
+            QHash<QString, FileMeta> fileNames( this->waiting.take( key ));
+            QHash<QString, FileMeta>::const_iterator i;
+
+            this->pendingKeys.remove( key );
+
+            // no icon, files that were waiting for it request it on their own when repainted
+            if ( result.image.isNull()) {
+                for ( i = fileNames.constBegin(); i != fileNames.constEnd(); ++i ) {
+                    const QModelIndex shared( this->indexForPath( i.key()));
+
+                    if ( shared.isValid())
+                        changed << shared;
+                }
+                continue;
+            }
+
+            IconStore::instance()->insert( key, QIcon( QPixmap::fromImage( result.image )));
+            fileNames[result.fileName] = request->meta;
+
+            for ( i = fileNames.constBegin(); i != fileNames.constEnd(); ++i ) {
+                const QModelIndex shared( this->indexForPath( i.key()));
+
+                this->setSharedIcon( i.key(), key, i.value().modified, i.value().isSymLink() || i.key().endsWith( ".appref-ms" ));
+                if ( shared.isValid())
+                    changed << shared;
+            }
+            continue;
+        }
+
+        if ( result.image.isNull())
+            continue;
 
 #ifdef ALT_PROXY_MODE
-    //
-    // this is a little more inefficient, however we don't have to deal with QPersistentModelIndex
-    // that is prone to corruption
-    //
-    for ( y = 0; y < this->rowCount( this->view->rootIndex()); y++ ) {
-        index = this->index( y, 0, this->view->rootIndex());
+        // look up by path, so that we don't have to deal with QPersistentModelIndex
+        // that is prone to corruption
+        index = this->indexForPath( result.fileName );
+#endif
+
         if ( !index.isValid())
             continue;
 
-        if ( !QString::compare( index.data( QFileSystemModel::FilePathRole ).toString(), fileName )) {
-            found = true;
-            break;
+        this->cache[result.fileName] = ProxyCacheEntry( QIcon( QPixmap::fromImage( result.image )), request->meta.modified, request->meta.isSymLink() || result.fileName.endsWith( ".appref-ms" ));
+        changed << index;
+    }
+
+    this->emitIconsChanged( changed );
+}
+
+/**
+ * @brief ProxyModel::emitIconsChanged notifies views with merged row ranges (only decorations have
+ * changed; these are emitted by the proxy itself, so they never reach QSortFilterProxyModel's
+ * re-sorting of source changes)
+ * @param changed
+ */
+void ProxyModel::emitIconsChanged( QModelIndexList changed ) {
+    int y;
+
+    std::sort( changed.begin(), changed.end());
+    for ( y = 0; y < changed.count(); y++ ) {
+        const QModelIndex top( changed.at( y ));
+
+        while ( y + 1 < changed.count() && changed.at( y + 1 ).parent() == top.parent() && changed.at( y + 1 ).row() <= changed.at( y ).row() + 1 )
+            y++;
+
+        emit this->dataChanged( top, changed.at( y ), QVector<int>() << Qt::DecorationRole );
+    }
+}
+
+/**
+ * @brief ProxyModel::setSourceModel
+ * @param model
+ */
+void ProxyModel::setSourceModel( QAbstractItemModel *model ) {
+    // disconnect only own slots (base class connections must stay intact)
+    if ( this->sourceModel() != nullptr ) {
+        this->disconnect( this->sourceModel(), SIGNAL( rowsInserted( QModelIndex, int, int )), this, SLOT( sourceRowsInserted( QModelIndex, int, int )));
+        this->disconnect( this->sourceModel(), SIGNAL( rowsRemoved( QModelIndex, int, int )), this, SLOT( sourceRowsRemoved( QModelIndex, int, int )));
+        this->disconnect( this->sourceModel(), SIGNAL( rowsMoved( QModelIndex, int, int, QModelIndex, int )), this, SLOT( invalidateRows()));
+        this->disconnect( this->sourceModel(), SIGNAL( layoutChanged()), this, SLOT( invalidateRows()));
+        this->disconnect( this->sourceModel(), SIGNAL( modelReset()), this, SLOT( invalidateRows()));
+        this->disconnect( this->sourceModel(), SIGNAL( rowsAboutToBeRemoved( QModelIndex, int, int )), this, SLOT( sourceRowsAboutToBeRemoved( QModelIndex, int, int )));
+        this->disconnect( this->sourceModel(), SIGNAL( modelReset()), this, SLOT( clearSortKeys()));
+        this->disconnect( this->sourceModel(), SIGNAL( dataChanged( QModelIndex, QModelIndex, QVector<int> )), this, SLOT( sourceDataChanged( QModelIndex, QModelIndex )));
+        this->disconnect( this->sourceModel(), SIGNAL( rowsInserted( QModelIndex, int, int )), this, SLOT( searchRowsInserted( QModelIndex, int, int )));
+        this->disconnect( this->sourceModel(), SIGNAL( modelReset()), this, SLOT( resetSearchIndex()));
+    }
+
+    // search is per directory
+    this->searchIndex.clear();
+    this->searchRoot = QPersistentModelIndex();
+
+    // sort keys are per source model (removed and changed rows drop their keys and icons
+    // before the base class sees them)
+    this->sortKeys.clear();
+    this->updateSortKeyOptions();
+    if ( model != nullptr ) {
+        this->connect( model, SIGNAL( rowsAboutToBeRemoved( QModelIndex, int, int )), this, SLOT( sourceRowsAboutToBeRemoved( QModelIndex, int, int )));
+        this->connect( model, SIGNAL( modelReset()), this, SLOT( clearSortKeys()));
+        this->connect( model, SIGNAL( dataChanged( QModelIndex, QModelIndex, QVector<int> )), this, SLOT( sourceDataChanged( QModelIndex, QModelIndex )));
+
+        // search index must know new entries before the base class filters them
+        this->connect( model, SIGNAL( rowsInserted( QModelIndex, int, int )), this, SLOT( searchRowsInserted( QModelIndex, int, int )));
+        this->connect( model, SIGNAL( modelReset()), this, SLOT( resetSearchIndex()));
+    }
+
+    QSortFilterProxyModel::setSourceModel( model );
+    this->invalidateRows();
+
+    if ( model == nullptr )
+        return;
+
+    // keep path to row mapping in sync with the source model
+    this->connect( model, SIGNAL( rowsInserted( QModelIndex, int, int )), this, SLOT( sourceRowsInserted( QModelIndex, int, int )));
+    this->connect( model, SIGNAL( rowsRemoved( QModelIndex, int, int )), this, SLOT( sourceRowsRemoved( QModelIndex, int, int )));
+    this->connect( model, SIGNAL( rowsMoved( QModelIndex, int, int, QModelIndex, int )), this, SLOT( invalidateRows()));
+    this->connect( model, SIGNAL( layoutChanged()), this, SLOT( invalidateRows()));
+    this->connect( model, SIGNAL( modelReset()), this, SLOT( invalidateRows()));
+}
+
+/**
+ * @brief ProxyModel::sourceRootIndex
+ * @return
+ */
+QModelIndex ProxyModel::sourceRootIndex() const {
+    if ( this->view == nullptr )
+        return QModelIndex();
+
+    return this->mapToSource( this->view->rootIndex());
+}
+
+/**
+ * @brief ProxyModel::rebuildRows
+ * @param sourceRoot
+ */
+void ProxyModel::rebuildRows( const QModelIndex &sourceRoot ) {
+    int y;
+
+    this->rows.clear();
+    this->paths.clear();
+    this->m_rowsRoot = sourceRoot.data( QFileSystemModel::FilePathRole ).toString();
+    this->m_rowsDirty = false;
+
+    if ( this->sourceModel() == nullptr || !sourceRoot.isValid())
+        return;
+
+    const int count = this->sourceModel()->rowCount( sourceRoot );
+    this->paths.reserve( count );
+    this->rows.reserve( count );
+    for ( y = 0; y < count; y++ ) {
+        const QString fileName( this->sourceModel()->index( y, 0, sourceRoot ).data( QFileSystemModel::FilePathRole ).toString());
+
+        this->paths << fileName;
+        this->rows[fileName] = y;
+    }
+}
+
+/**
+ * @brief ProxyModel::sourceRowsInserted appends to the mapping, rebuilds it lazily otherwise
+ * @param parent
+ * @param first
+ * @param last
+ */
+void ProxyModel::sourceRowsInserted( const QModelIndex &parent, int first, int last ) {
+    int y;
+
+    if ( this->m_rowsDirty || QString::compare( parent.data( QFileSystemModel::FilePathRole ).toString(), this->m_rowsRoot ))
+        return;
+
+    if ( first != this->paths.count()) {
+        this->invalidateRows();
+        return;
+    }
+
+    for ( y = first; y <= last; y++ ) {
+        const QString fileName( this->sourceModel()->index( y, 0, parent ).data( QFileSystemModel::FilePathRole ).toString());
+
+        this->paths << fileName;
+        this->rows[fileName] = y;
+    }
+}
+
+/**
+ * @brief ProxyModel::sourceRowsRemoved drops from the end of the mapping, rebuilds it lazily otherwise
+ * @param parent
+ * @param first
+ * @param last
+ */
+void ProxyModel::sourceRowsRemoved( const QModelIndex &parent, int first, int last ) {
+    // rows beyond the item limit move up into it
+    if ( !this->m_limitDirty && this->isLimited( parent )) {
+        this->m_limitDirty = true;
+        QMetaObject::invokeMethod( this, "updateLimit", Qt::QueuedConnection );
+    }
+
+    if ( this->m_rowsDirty || QString::compare( parent.data( QFileSystemModel::FilePathRole ).toString(), this->m_rowsRoot ))
+        return;
+
+    if ( last != this->paths.count() - 1 ) {
+        this->invalidateRows();
+        return;
+    }
+
+    while ( this->paths.count() > first )
+        this->rows.remove( this->paths.takeLast());
+}
+
+/**
+ * @brief ProxyModel::indexForPath maps file path to proxy index in O(1)
+ * @param fileName
+ * @return
+ */
+QModelIndex ProxyModel::indexForPath( const QString &fileName ) {
+    const QModelIndex sourceRoot( this->sourceRootIndex());
+    int row;
+
+    if ( this->sourceModel() == nullptr || !sourceRoot.isValid())
+        return QModelIndex();
+
+    if ( this->m_rowsDirty || QString::compare( sourceRoot.data( QFileSystemModel::FilePathRole ).toString(), this->m_rowsRoot ))
+        this->rebuildRows( sourceRoot );
+
+    row = this->rows.value( fileName, -1 );
+    if ( row < 0 )
+        return QModelIndex();
+
+    return this->mapFromSource( this->sourceModel()->index( row, 0, sourceRoot ));
+}
+
+/**
+ * @brief ProxyModel::setVisibleRange
+ * @param first
+ * @param last
+ */
+void ProxyModel::setVisibleRange( int first, int last ) {
+    if ( first == this->m_firstVisible && last == this->m_lastVisible )
+        return;
+
+    // remember scroll direction for prefetching
+    if ( first > this->m_firstVisible )
+        this->m_direction = 1;
+    else if ( first < this->m_firstVisible )
+        this->m_direction = -1;
+
+    this->m_firstVisible = first;
+    this->m_lastVisible = last;
+
+    // reprioritize pending requests
+    this->m_orderDirty = true;
+    if ( !this->dispatchTimer.isActive())
+        this->dispatchTimer.start();
+}
+
+/**
+ * @brief ProxyModel::priority lower values are submitted first (visible rows, then rows
+ * ahead in the scroll direction, then rows behind)
+ * @param row
+ * @return
+ */
+int ProxyModel::priority( int row ) const {
+    int distance;
+    bool ahead;
+
+    // viewport unknown, keep model order
+    if ( this->m_lastVisible < 0 )
+        return row;
+
+    const int span = this->m_lastVisible - this->m_firstVisible + 1;
+    if ( row >= this->m_firstVisible && row <= this->m_lastVisible )
+        return row - this->m_firstVisible;
+
+    if ( row > this->m_lastVisible ) {
+        distance = row - this->m_lastVisible;
+        ahead = this->m_direction >= 0;
+    } else {
+        distance = this->m_firstVisible - row;
+        ahead = this->m_direction < 0;
+    }
+
+    return span + ( ahead ? distance : distance * 2 );
+}
+
+/**
+ * @brief ProxyModel::isWithinMargin checks if row is inside the viewport and prefetch margin
+ * (one page behind, two pages ahead in the scroll direction)
+ * @param row
+ * @return
+ */
+bool ProxyModel::isWithinMargin( int row ) const {
+    if ( this->m_lastVisible < 0 )
+        return true;
+
+    const int margin = qMax( this->m_lastVisible - this->m_firstVisible + 1, ProxyModelNamespace::MinimumMargin );
+    const int before = this->m_direction < 0 ? margin * 2 : margin;
+    const int after = this->m_direction < 0 ? margin : margin * 2;
+
+    return row >= this->m_firstVisible - before && row <= this->m_lastVisible + after;
+}
+
+/**
+ * @brief ProxyModel::priorityClass visible views go before hidden ones (previews, closed widgets)
+ * @return
+ */
+IconQueue::PriorityClasses ProxyModel::priorityClass() const {
+    return ( this->view != nullptr && this->view->isVisible()) ? IconQueue::Visible : IconQueue::Hidden;
+}
+
+/**
+ * @brief ProxyModel::rebuildOrder sorts queued requests in viewport-first order
+ */
+void ProxyModel::rebuildOrder() {
+    QList<ProxyPriority> queued;
+    QMutableHashIterator<QString, ProxyRequest> i( this->requests );
+
+    while ( i.hasNext()) {
+        i.next();
+
+        if ( i.value().state != ProxyRequest::Queued )
+            continue;
+
+        // cancel requests that have left the viewport, views ask again when painting
+        if ( !this->isWithinMargin( i.value().row )) {
+            this->setState( i.value(), ProxyRequest::Cancelled );
+            if ( !i.value().key.isEmpty() && !QString::compare( this->pendingKeys.value( i.value().key ), i.key()))
+                this->pendingKeys.remove( i.value().key );
+            continue;
         }
+
+        queued << qMakePair( this->priority( i.value().row ), i.key());
     }
+    std::sort( queued.begin(), queued.end());
+
+    this->order.clear();
+    foreach ( const ProxyPriority &request, queued )
+        this->order << request.second;
+
+    this->m_orderDirty = false;
+}
+
+/**
+ * @brief ProxyModel::dispatch reprioritizes pending requests and wakes up the shared scheduler
+ */
+void ProxyModel::dispatch() {
+    if ( this->m_orderDirty )
+        this->rebuildOrder();
+
+    if ( !this->order.isEmpty())
+        IconScheduler::instance()->schedule();
+}
+
+/**
+ * @brief ProxyModel::setState updates request state and per-state counters
+ * @param request
+ * @param state
+ */
+void ProxyModel::setState( ProxyRequest &request, ProxyRequest::States state ) const {
+    if ( request.state != ProxyRequest::NoState )
+        this->m_stateCounts[request.state]--;
+
+    request.state = state;
+
+    if ( state != ProxyRequest::NoState )
+        this->m_stateCounts[state]++;
+}
+
+/**
+ * @brief ProxyModel::clearCache
+ */
+void ProxyModel::clearCache() {
+    QMutableHashIterator<QString, ProxyRequest> i( this->requests );
+
+    // in-flight results were made with old options
+    this->cancel();
+    this->cache.clear();
+    this->releaseSharedIcons();
+
+    // all requests must be repeated
+    while ( i.hasNext()) {
+        i.next();
+        this->setState( i.value(), ProxyRequest::NoState );
+        i.remove();
+    }
+}
+
+/**
+ * @brief ProxyModel::invalidateFile marks the icon of a file as outdated (it is still shown until the
+ * new one arrives)
+ * @param fileName
+ */
+void ProxyModel::invalidateFile( const QString &fileName ) {
+    const QHash<QString, ProxyCacheEntry>::iterator entry( this->cache.find( fileName ));
+    const QHash<QString, ProxyRequest>::iterator request( this->requests.find( fileName ));
+
+    if ( entry != this->cache.end())
+        entry->stale = true;
 
-    if ( !found )
+    if ( request == this->requests.end())
         return;
-#endif
 
-    if ( !index.isValid())
+    // queued requests fetch the current revision anyway, running ones are dropped on arrival
+    switch ( request->state ) {
+    case ProxyRequest::Running:
+        this->setState( *request, ProxyRequest::Cancelled );
+        if ( !request->key.isEmpty() && !QString::compare( this->pendingKeys.value( request->key ), fileName ))
+            this->pendingKeys.remove( request->key );
+        break;
+
+    case ProxyRequest::Done:
+        this->setState( *request, ProxyRequest::NoState );
+        this->requests.erase( request );
+        break;
+
+    case ProxyRequest::NoState:
+    case ProxyRequest::Queued:
+    case ProxyRequest::Cancelled:
+    case ProxyRequest::StateCount:
+        break;
+    }
+}
+
+/**
+ * @brief ProxyModel::forget drops icon and request of a removed file
+ * @param fileName
+ */
+void ProxyModel::forget( const QString &fileName ) {
+    const QHash<QString, ProxyRequest>::iterator request( this->requests.find( fileName ));
+
+    this->releaseSharedIcon( this->cache.take( fileName ).key );
+
+    if ( request == this->requests.end())
+        return;
+
+    if ( !request->key.isEmpty() && !QString::compare( this->pendingKeys.value( request->key ), fileName ))
+        this->pendingKeys.remove( request->key );
+
+    this->setState( *request, ProxyRequest::NoState );
+    this->requests.erase( request );
+}
+
+/**
+ * @brief ProxyModel::invalidateIcons refetches all icons after an option change (e.g. icon size),
+ * without clearing the view in the meantime
+ */
+void ProxyModel::invalidateIcons() {
+    QModelIndexList changed;
+
+    // in-flight results were made with old options
+    this->cancel();
+    this->releaseSharedIcons();
+
+    foreach ( const QString &fileName, this->cache.keys()) {
+        const QModelIndex index( this->indexForPath( fileName ));
+
+        this->invalidateFile( fileName );
+        if ( index.isValid())
+            changed << index;
+    }
+
+    // files without an icon are asked for again as well
+    foreach ( const QString &fileName, this->requests.keys())
+        this->invalidateFile( fileName );
+
+    this->emitIconsChanged( changed );
+}
+
+/**
+ * @brief ProxyModel::invalidateSymlinkIcons refetches only icons with symlink labels
+ */
+void ProxyModel::invalidateSymlinkIcons() {
+    QModelIndexList changed;
+
+    foreach ( const QString &fileName, this->cache.keys()) {
+        if ( !this->cache[fileName].symLink )
+            continue;
+
+        const QModelIndex index( this->indexForPath( fileName ));
+
+        this->invalidateFile( fileName );
+        if ( index.isValid())
+            changed << index;
+    }
+
+    // running symlink requests use the previous setting
+    foreach ( const ProxyRequest &request, this->requests.values()) {
+        if ( request.state == ProxyRequest::Running && ( request.meta.isSymLink() || request.fileName.endsWith( ".appref-ms" )))
+            this->invalidateFile( request.fileName );
+    }
+
+    this->emitIconsChanged( changed );
+}
+
+/**
+ * @brief ProxyModel::sourceDataChanged refetches icons of files whose modification time has changed
+ * @param topLeft
+ * @param bottomRight
+ */
+void ProxyModel::sourceDataChanged( const QModelIndex &topLeft, const QModelIndex &bottomRight ) {
+    int y;
+
+    // renamed entries
+    if ( this->searchRoot.isValid() && topLeft.parent() == this->searchRoot ) {
+        for ( y = topLeft.row(); y <= bottomRight.row(); y++ ) {
+            const QModelIndex index( this->sourceModel()->index( y, 0, topLeft.parent()));
+            this->searchIndex.insert( index.internalId(), index.data( QFileSystemModel::FileNameRole ).toString());
+        }
+    }
+
+    if ( this->cache.isEmpty() && this->requests.isEmpty())
         return;
 
-    // NOTE: random segfault here (might be fixed by using QPersistentModelIndex)
-    emit this->dataChanged( index, index );
-    this->cache[fileName] = icon;
-    this->queue.removeOne( fileName );
+    for ( y = topLeft.row(); y <= bottomRight.row(); y++ ) {
+        const QModelIndex index( this->sourceModel()->index( y, 0, topLeft.parent()));
+        const QString fileName( index.data( QFileSystemModel::FilePathRole ).toString());
+        const QHash<QString, ProxyCacheEntry>::const_iterator entry( this->cache.constFind( fileName ));
+        const QHash<QString, ProxyRequest>::const_iterator request( this->requests.constFind( fileName ));
+        qint64 modified;
+
+        if ( entry != this->cache.constEnd())
+            modified = entry->modified;
+        else if ( request != this->requests.constEnd() && request->state == ProxyRequest::Running )
+            modified = request->meta.modified;
+        else
+            continue;
+
+        if ( qvariant_cast<FileMeta>( index.data( FileMetaNamespace::FileMetaRole )).modified != modified )
+            this->invalidateFile( fileName );
+    }
+}
+
+/**
+ * @brief ProxyModel::takeTask hands the next request over to the shared scheduler
+ * (tasks are taken one at a time, only when a worker is free)
+ * @return
+ */
+std::function<void()> ProxyModel::takeTask() {
+    int iconSize, generation;
+
+    if ( this->view == nullptr )
+        return std::function<void()>();
+
+    if ( this->m_orderDirty )
+        this->rebuildOrder();
+
+    iconSize = this->view->iconSize();
+    generation = this->guard->generation.load();
+    while ( !this->order.isEmpty()) {
+        const QHash<QString, ProxyRequest>::iterator next( this->requests.find( this->order.takeFirst()));
+
+        if ( next == this->requests.end() || next->state != ProxyRequest::Queued )
+            continue;
+
+        this->setState( *next, ProxyRequest::Running );
+
+        const ProxyRequest request( *next );
+        const QSharedPointer<ProxyTaskGuard> guard( this->guard );
+        return [ guard, request, iconSize, generation ] {
+            // checked by the icon pipeline between stages (a load shared with other views
+            // keeps running as long as any of them still wants it)
+            const IconCancelled cancelled( [ guard, generation ]() { return guard->generation.load() != generation; } );
+
+            if ( cancelled())
+                return;
+
+            // a load already in flight elsewhere calls back later, the worker is released at once
+            IconCache::instance()->requestImageForFilename( request.meta.isValid() ? request.meta : FileMeta::fromFileInfo( QFileInfo( request.fileName )), iconSize, false, cancelled, [ guard, request, generation, cancelled ]( const QImage &image ) {
+                // report empty results too, so that the request is marked as done
+                QReadLocker lock( &guard->lock );
+                if ( guard->model == nullptr || cancelled())
+                    return;
+
+#ifdef ALT_PROXY_MODE
+                guard->model->pushResult( ProxyIcon( request.fileName, image, generation, request.handle ));
+#else
+                guard->model->pushResult( ProxyIcon( request.fileName, image, generation, request.handle, request.index ));
+#endif
+            } );
+        };
+    }
+
+    return std::function<void()>();
 }
 
 /**
@@ -125,41 +810,80 @@ void ProxyModel::updateModel( const QString &fileName, const QIcon &icon, const
  * @return
  */
 QVariant ProxyModel::data( const QModelIndex &index, int role ) const {
-    if ( this->isStopping())
-        return QVariant();
-
     if ( role == QFileSystemModel::FileIconRole ) {
         const QString fileName( index.data( QFileSystemModel::FilePathRole ).toString());
-        const int iconSize = this->view->iconSize();
 
-        if ( this->cache.contains( fileName ))
-            return this->cache[fileName];
+        const QHash<QString, ProxyCacheEntry>::const_iterator cached( this->cache.constFind( fileName ));
+        if ( cached != this->cache.constEnd() && !cached->stale )
+            return cached->icon;
 
-        // add to queue and avoid duplicates
-        if ( this->queue.contains( fileName ))
-            return QSortFilterProxyModel::data( index, role );
-        else
-            this->queue.append( fileName );
+        // avoid duplicate requests (views only paint visible items, so keep row current)
+        QHash<QString, ProxyRequest>::iterator request( this->requests.find( fileName ));
+        if ( request != this->requests.end()) {
+            switch ( request->state ) {
+            case ProxyRequest::Queued:
+                if ( request->row != index.row()) {
+                    request->row = index.row();
+                    this->m_orderDirty = true;
+                }
+                return this->placeholder( index, role );
 
-        // run fetcher
-#ifdef ALT_PROXY_MODE
-        QtConcurrent::run( this->threadPool, [ this, fileName, iconSize ] {
-#else
-        QPersistentModelIndex persistentIndex( index );
-        QtConcurrent::run( this->threadPool, [ this, fileName, persistentIndex, iconSize ] {
-#endif
-            if ( this->isStopping())
-                return;
+            case ProxyRequest::Cancelled:
+                // request again below
+                break;
 
-            const QIcon icon( IconCache::instance()->iconForFilename( fileName, iconSize ));
-            if ( !icon.isNull() || this->isStopping()) {
-#ifdef ALT_PROXY_MODE
-                emit this->iconFound( fileName, icon );
-#else
-                emit this->iconFound( fileName, icon, persistentIndex );
-#endif
+            case ProxyRequest::NoState:
+            case ProxyRequest::Running:
+            case ProxyRequest::Done:
+            case ProxyRequest::StateCount:
+                return this->placeholder( index, role );
             }
-        } );
+        }
+
+        // collect file metadata once (from the source model's cached file info)
+        const FileMeta meta( qvariant_cast<FileMeta>( index.data( FileMetaNamespace::FileMetaRole )));
+        const QString key( IconCache::instance()->iconKey( meta, this->view != nullptr ? this->view->iconSize() : 0 ));
+
+        // files of the same type (or the same file in other views) share a single icon and a single request
+        if ( !key.isEmpty()) {
+            if ( IconStore::instance()->contains( key )) {
+                return this->setSharedIcon( fileName, key, meta.modified, meta.isSymLink() || fileName.endsWith( ".appref-ms" ));
+            }
+
+            const QHash<QString, ProxyRequest>::iterator pending( this->requests.find( this->pendingKeys.value( key )));
+            if ( pending != this->requests.end() && ( pending->state == ProxyRequest::Queued || pending->state == ProxyRequest::Running )) {
+                this->waiting[key][fileName] = meta;
+
+                // pending request follows the last painted file that needs it
+                if ( pending->state == ProxyRequest::Queued && pending->row != index.row()) {
+                    pending->row = index.row();
+                    this->m_orderDirty = true;
+                    if ( !this->dispatchTimer.isActive())
+                        this->dispatchTimer.start();
+                }
+                return this->placeholder( index, role );
+            }
+
+            this->pendingKeys[key] = fileName;
+        }
+
+        if ( request == this->requests.end())
+            request = this->requests.insert( fileName, ProxyRequest( fileName ));
+
+        // results of previous requests for this file are superseded
+        request->handle = this->m_nextHandle++;
+        request->key = key;
+        request->meta = meta;
+        request->row = index.row();
+#ifndef ALT_PROXY_MODE
+        request->index = QPersistentModelIndex( index );
+#endif
+
+        // queue request, the dispatcher submits it by priority
+        this->setState( *request, ProxyRequest::Queued );
+        this->m_orderDirty = true;
+        if ( !this->dispatchTimer.isActive())
+            this->dispatchTimer.start();
     } else if ( role == Qt::DisplayRole ) {
 #ifdef Q_OS_WIN
         // TODO: make this a static function (duplicate in IconCache)
@@ -182,6 +906,273 @@ QVariant ProxyModel::data( const QModelIndex &index, int role ) const {
     return QSortFilterProxyModel::data( index, role );
 }
 
+/**
+ * @brief ProxyModel::placeholder returns an outdated icon while the current one is being fetched
+ * @param index
+ * @param role
+ * @return
+ */
+QVariant ProxyModel::placeholder( const QModelIndex &index, int role ) const {
+    const QHash<QString, ProxyCacheEntry>::const_iterator cached( this->cache.constFind( index.data( QFileSystemModel::FilePathRole ).toString()));
+
+    if ( cached != this->cache.constEnd())
+        return cached->icon;
+
+    return QSortFilterProxyModel::data( index, role );
+}
+
+/**
+ * @brief ProxyModel::resort re-sorts after sort option changes without resetting the model
+ * (unlike setSourceModel this keeps the proxy mapping, persistent indexes and icon caches)
+ */
+void ProxyModel::resort() {
+    // case sensitivity and numeric mode change the keys themselves
+    this->updateSortKeyOptions();
+
+    // sort() ignores unchanged column and order, rebuild the mapping in a single layout pass instead
+    if ( this->sortColumn() < 0 )
+        this->sort( 0 );
+    else
+        this->QSortFilterProxyModel::invalidate();
+}
+
+/**
+ * @brief ProxyModel::setMaxItems limits the number of entries shown (0 shows all), so that
+ * huge directories are neither fully populated nor laid out
+ * @param count
+ */
+void ProxyModel::setMaxItems( int count ) {
+    const QModelIndex sourceRoot( this->sourceRootIndex());
+
+    count = qMax( 0, count );
+    if ( count == this->m_maxItems )
+        return;
+
+    this->m_maxItems = count;
+    this->invalidateFilter();
+
+    // raised limit might need entries the source has not populated yet
+    if ( sourceRoot.isValid() && this->canFetchMore( this->mapFromSource( sourceRoot )))
+        this->fetchMore( this->mapFromSource( sourceRoot ));
+}
+
+/**
+ * @brief ProxyModel::isLimited returns true if the item limit hides (or would hide) entries
+ * @param sourceParent
+ * @return
+ */
+bool ProxyModel::isLimited( const QModelIndex &sourceParent ) const {
+    if ( this->m_maxItems <= 0 || this->sourceModel() == nullptr || !this->isSourceRoot( sourceParent ))
+        return false;
+
+    return this->sourceModel()->rowCount( sourceParent ) >= this->m_maxItems;
+}
+
+/**
+ * @brief ProxyModel::isSourceRoot returns true for the directory shown in the view (the
+ * source model might also contain its ancestors)
+ * @param sourceParent
+ * @return
+ */
+bool ProxyModel::isSourceRoot( const QModelIndex &sourceParent ) const {
+    if ( this->view == nullptr || !sourceParent.isValid())
+        return false;
+
+    return !QString::compare( sourceParent.data( QFileSystemModel::FilePathRole ).toString(), this->view->sourceRootPath());
+}
+
+/**
+ * @brief ProxyModel::hasMoreItems returns true if the item limit hides entries
+ * @return
+ */
+bool ProxyModel::hasMoreItems() const {
+    const QModelIndex sourceRoot( this->sourceRootIndex());
+
+    if ( !this->isLimited( sourceRoot ))
+        return false;
+
+    return this->sourceModel()->rowCount( sourceRoot ) > this->m_maxItems || this->sourceModel()->canFetchMore( sourceRoot );
+}
+
+/**
+ * @brief ProxyModel::canFetchMore stops populating the source once the item limit is reached
+ * @param parent
+ * @return
+ */
+bool ProxyModel::canFetchMore( const QModelIndex &parent ) const {
+    if ( this->isLimited( this->mapToSource( parent )))
+        return false;
+
+    return QSortFilterProxyModel::canFetchMore( parent );
+}
+
+/**
+ * @brief ProxyModel::setFilterRules compiles per view filter rules and filters again
+ * @param rules
+ */
+void ProxyModel::setFilterRules( const FileFilterRules &rules ) {
+    this->fileFilter.setRules( rules );
+    this->invalidateFilter();
+}
+
+/**
+ * @brief ProxyModel::setSearchText narrows the view to entries containing the text (the index is
+ * built on first use and kept up to date while searching)
+ * @param text
+ */
+void ProxyModel::setSearchText( const QString &text ) {
+    if ( text.isEmpty()) {
+        if ( this->searchIndex.query().isEmpty())
+            return;
+
+        this->searchIndex.clear();
+        this->searchRoot = QPersistentModelIndex();
+        this->invalidateFilter();
+        return;
+    }
+
+    // index is only kept while searching
+    if ( this->searchIndex.query().isEmpty())
+        this->rebuildSearchIndex();
+
+    if ( !QString::compare( text.toCaseFolded(), this->searchIndex.query()))
+        return;
+
+    this->searchIndex.setQuery( text );
+    this->invalidateFilter();
+}
+
+/**
+ * @brief ProxyModel::rebuildSearchIndex indexes names of all entries in the view's directory
+ * (keeps the current query)
+ */
+void ProxyModel::rebuildSearchIndex() {
+    const QString query( this->searchIndex.query());
+    const QModelIndex sourceRoot( this->sourceRootIndex());
+    int y;
+
+    this->searchIndex.clear();
+    this->searchRoot = sourceRoot;
+    if ( this->sourceModel() == nullptr || !sourceRoot.isValid())
+        return;
+
+    for ( y = 0; y < this->sourceModel()->rowCount( sourceRoot ); y++ ) {
+        const QModelIndex index( this->sourceModel()->index( y, 0, sourceRoot ));
+        this->searchIndex.insert( index.internalId(), index.data( QFileSystemModel::FileNameRole ).toString());
+    }
+
+    if ( !query.isEmpty()) {
+        this->searchIndex.setQuery( query );
+        this->invalidateFilter();
+    }
+}
+
+/**
+ * @brief ProxyModel::searchRowsInserted adds new entries to the search index
+ * @param parent
+ * @param first
+ * @param last
+ */
+void ProxyModel::searchRowsInserted( const QModelIndex &parent, int first, int last ) {
+    int y;
+
+    if ( !this->searchRoot.isValid() || parent != this->searchRoot )
+        return;
+
+    for ( y = first; y <= last; y++ ) {
+        const QModelIndex index( this->sourceModel()->index( y, 0, parent ));
+        this->searchIndex.insert( index.internalId(), index.data( QFileSystemModel::FileNameRole ).toString());
+    }
+}
+
+/**
+ * @brief ProxyModel::filterAcceptsRow hides entries beyond the item limit (in directory order,
+ * so that no entry has to be compared before it is shown) and entries rejected by the filter
+ * rules (matched on the name and cached metadata, never stats the file)
+ * @param sourceRow
+ * @param sourceParent
+ * @return
+ */
+bool ProxyModel::filterAcceptsRow( int sourceRow, const QModelIndex &sourceParent ) const {
+    const bool limited = this->m_maxItems > 0 && sourceRow >= this->m_maxItems;
+
+    if (( limited || !this->fileFilter.isEmpty()) && this->isSourceRoot( sourceParent )) {
+        if ( limited || !this->fileFilter.accepts( this->sourceModel()->index( sourceRow, 0, sourceParent )))
+            return false;
+    }
+
+    // type-to-filter
+    if ( this->searchRoot.isValid() && sourceParent == this->searchRoot && !this->searchIndex.matches( this->sourceModel()->index( sourceRow, 0, sourceParent ).internalId()))
+        return false;
+
+    return QSortFilterProxyModel::filterAcceptsRow( sourceRow, sourceParent );
+}
+
+/**
+ * @brief ProxyModel::updateSortKeyOptions drops sort keys if key options have changed
+ */
+void ProxyModel::updateSortKeyOptions() {
+    const bool caseSensitive = this->view != nullptr && this->view->isCaseSensitive();
+    const bool numeric = this->view != nullptr && this->view->isNumericSort();
+
+    if ( caseSensitive == this->m_keyCaseSensitive && numeric == this->m_keyNumeric )
+        return;
+
+    this->m_keyCaseSensitive = caseSensitive;
+    this->m_keyNumeric = numeric;
+    this->collator.setCaseSensitivity( caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive );
+    this->collator.setNumericMode( numeric );
+    this->sortKeys.clear();
+}
+
+/**
+ * @brief ProxyModel::sourceRowsAboutToBeRemoved drops sort keys and icons of removed (or renamed) rows
+ * @param parent
+ * @param first
+ * @param last
+ */
+void ProxyModel::sourceRowsAboutToBeRemoved( const QModelIndex &parent, int first, int last ) {
+    int y;
+
+    if ( this->searchRoot.isValid() && parent == this->searchRoot ) {
+        for ( y = first; y <= last; y++ )
+            this->searchIndex.remove( this->sourceModel()->index( y, 0, parent ).internalId());
+    }
+
+    if ( this->sortKeys.isEmpty() && this->cache.isEmpty() && this->requests.isEmpty())
+        return;
+
+    for ( y = first; y <= last; y++ ) {
+        const QModelIndex index( this->sourceModel()->index( y, 0, parent ));
+
+        this->sortKeys.remove( index.internalId());
+        this->forget( index.data( QFileSystemModel::FilePathRole ).toString());
+    }
+}
+
+/**
+ * @brief ProxyModel::sortKey returns (and caches) the sort key of a source index
+ * @param index
+ * @return
+ */
+ProxySortKey ProxyModel::sortKey( const QModelIndex &index ) const {
+    const QHash<quintptr, ProxySortKey>::const_iterator cached( this->sortKeys.constFind( index.internalId()));
+    FileSystemModel *fileSystemModel;
+    ProxySortKey key;
+
+    if ( cached != this->sortKeys.constEnd())
+        return cached.value();
+
+    fileSystemModel = qobject_cast<FileSystemModel*>( this->sourceModel());
+    if ( fileSystemModel == nullptr )
+        return key;
+
+    // node data is cached by the model, no stat calls
+    key = ProxySortKey::fromName( fileSystemModel->fileName( index ), fileSystemModel->isDir( index ), this->m_keyCaseSensitive, this->m_keyNumeric ? &this->collator : nullptr );
+    this->sortKeys.insert( index.internalId(), key );
+    return key;
+}
+
 /**
  * @brief ProxyModel::lessThan
  * @param left
@@ -190,32 +1181,17 @@ QVariant ProxyModel::data( const QModelIndex &index, int role ) const {
  */
 bool ProxyModel::lessThan( const QModelIndex &left, const QModelIndex &right ) const {
     if ( this->sortColumn() == 0 ) {
-        FileSystemModel *fileSystemModel;
-        bool value;
-
-        fileSystemModel = qobject_cast<FileSystemModel*>( this->sourceModel());
-        if ( fileSystemModel == nullptr || this->view == nullptr )
+        if ( qobject_cast<FileSystemModel*>( this->sourceModel()) == nullptr || this->view == nullptr )
             return QSortFilterProxyModel::lessThan( left, right );
 
-        const bool compare = this->view->sortOrder() == Qt::AscendingOrder;
-        const QFileInfo leftInfo( fileSystemModel->fileInfo( left ));
-        const QFileInfo rightInfo( fileSystemModel->fileInfo( right ));
-
-        if ( this->view->directoriesFirst()) {
-            if ( !leftInfo.isDir() && rightInfo.isDir())
-                return false;
+        const ProxySortKey leftKey( this->sortKey( left ));
+        const ProxySortKey rightKey( this->sortKey( right ));
 
-            if ( leftInfo.isDir() && !rightInfo.isDir())
-                return true;
-        }
-
-        if ( this->view->isCaseSensitive()) {
-            value = leftInfo.fileName() < rightInfo.fileName();
-            return compare ? value : !value;
-        }
+        if ( this->view->directoriesFirst() && leftKey.dir != rightKey.dir )
+            return leftKey.dir;
 
-        value = leftInfo.fileName().toLower() < rightInfo.fileName().toLower();
-        return compare ? value : !value;
+        const int result = leftKey.compare( rightKey );
+        return this->view->sortOrder() == Qt::AscendingOrder ? result < 0 : result > 0;
     }
 
     return QSortFilterProxyModel::lessThan( left, right );
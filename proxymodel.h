@@ -26,7 +26,19 @@
 #include <QIcon>
 #include <QIdentityProxyModel>
 #include <QSortFilterProxyModel>
-#include <QThreadPool>
+#include <QTimer>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QDebug>
+#include <QCollator>
+#include <QSharedPointer>
+#include <QSet>
+#include <QReadWriteLock>
+#include "filefilter.h"
+#include "filemeta.h"
+#include "iconscheduler.h"
+#include "iconstore.h"
+#include "searchindex.h"
 
 //
 // classes
@@ -39,20 +51,113 @@ class FolderView;
 #define ALT_PROXY_MODE
 
 /**
- * @brief The ProxyIcon struct
+ * @brief The ProxyModelNamespace namespace
+ */
+namespace ProxyModelNamespace {
+static const int BatchInterval = 16;
+static const int MinimumMargin = 32;
+static const int MoreItems = 1000;
+}
+
+/**
+ * @brief The ProxyRequest struct (entry in the icon request table)
+ */
+struct ProxyRequest {
+    enum States {
+        NoState = -1,
+        Queued,
+        Running,
+        Done,
+        Cancelled,
+        StateCount
+    };
+
+    explicit ProxyRequest( const QString &f = QString(), const FileMeta &m = FileMeta(), int r = -1, const QPersistentModelIndex &n = QPersistentModelIndex()) : fileName( f ), meta( m ), row( r ), index( n ), state( NoState ), handle( 0 ) {}
+    QString fileName;
+    QString key;
+    FileMeta meta;
+    int row;
+    QPersistentModelIndex index;
+    States state;
+    quint64 handle;
+};
+inline QDebug operator<<( QDebug debug, const ProxyRequest &request ) { QDebugStateSaver saver( debug ); debug.nospace() << "ProxyRequest(" << request.handle << ", " << request.fileName << ", row " << request.row << ", state " << request.state << ")"; return debug; }
+typedef QPair<int, QString> ProxyPriority;
+
+/**
+ * @brief The ProxySortKey struct (precomputed sort key of a source row)
+ */
+struct ProxySortKey {
+    ProxySortKey() : dir( false ) {}
+    static ProxySortKey fromName( const QString &fileName, bool dir, bool caseSensitive, const QCollator *collator = nullptr ) {
+        ProxySortKey key;
+        key.dir = dir;
+        if ( collator != nullptr )
+            key.collated = QSharedPointer<QCollatorSortKey>( new QCollatorSortKey( collator->sortKey( fileName )));
+        else
+            key.folded = caseSensitive ? fileName : fileName.toCaseFolded();
+        return key;
+    }
+    int compare( const ProxySortKey &other ) const { return ( !this->collated.isNull() && !other.collated.isNull()) ? this->collated->compare( *other.collated ) : this->folded.compare( other.folded ); }
+    bool dir;
+    QString folded;
+    QSharedPointer<QCollatorSortKey> collated;
+};
+
+/**
+ * @brief The ProxyIcon struct (worker result waiting for conversion on the GUI thread)
  */
 struct ProxyIcon {
-    explicit ProxyIcon( const QString &f = QString(), const QIcon &i = QIcon(), const QModelIndex &n = QModelIndex()) : fileName( f ), icon( i ), index( n ) {}
+    explicit ProxyIcon( const QString &f = QString(), const QImage &i = QImage(), int g = 0, quint64 h = 0, const QPersistentModelIndex &n = QPersistentModelIndex()) : fileName( f ), image( i ), generation( g ), handle( h ), index( n ) {}
     QString fileName;
-    QIcon icon;
-    QModelIndex index;
+    QImage image;
+    int generation;
+    quint64 handle;
+    QPersistentModelIndex index;
 };
 Q_DECLARE_METATYPE( ProxyIcon )
 
+/**
+ * @brief The ProxyCacheEntry struct (icon of a file and the file revision it was made for)
+ */
+struct ProxyCacheEntry {
+    explicit ProxyCacheEntry( const QIcon &i = QIcon(), qint64 m = 0, bool l = false ) : icon( i ), modified( m ), symLink( l ), stale( false ) {}
+    QIcon icon;
+    qint64 modified;
+    bool symLink;
+    bool stale;
+    QString key;
+};
+
+/**
+ * @brief The ProxyIconNode struct (node of the lock-free result queue)
+ */
+struct ProxyIconNode {
+    explicit ProxyIconNode( const ProxyIcon &i = ProxyIcon()) : icon( i ), next( nullptr ) {}
+    ProxyIcon icon;
+    ProxyIconNode *next;
+};
+
+//
+// classes
+//
+class ProxyModel;
+
+/**
+ * @brief The ProxyTaskGuard struct (shared by a model and its in-flight tasks, so that tasks can
+ * outlive the model; results of a cancelled generation or of a deleted model are dropped)
+ */
+struct ProxyTaskGuard {
+    explicit ProxyTaskGuard( ProxyModel *m = nullptr ) : model( m ), generation( 0 ) {}
+    QReadWriteLock lock;
+    ProxyModel *model;
+    QAtomicInt generation;
+};
+
 /**
  * @brief The ProxyModel class
  */
-class ProxyModel : public QSortFilterProxyModel {
+class ProxyModel : public QSortFilterProxyModel, public IconQueue {
     Q_OBJECT
     Q_DISABLE_COPY( ProxyModel )
 
@@ -60,7 +165,20 @@ public:
     explicit ProxyModel( QObject *parent = nullptr );
     ~ProxyModel();
     QVariant data( const QModelIndex &index, int role = Qt::DisplayRole ) const;
-    bool isStopping() const { QMutexLocker( &this->m_mutex ); return m_stopping; }
+    int generation() const { return this->guard->generation.load(); }
+    QList<ProxyRequest> requestTable() const { return this->requests.values(); }
+    int requestCount( ProxyRequest::States state ) const { return ( state > ProxyRequest::NoState && state < ProxyRequest::StateCount ) ? this->m_stateCounts[state] : 0; }
+    void setSourceModel( QAbstractItemModel *model );
+    QModelIndex indexForPath( const QString &fileName );
+    PriorityClasses priorityClass() const;
+    bool hasTasks() const { return this->m_stateCounts[ProxyRequest::Queued] > 0; }
+    std::function<void()> takeTask();
+    int maxItems() const { return this->m_maxItems; }
+    const FileFilterRules &filterRules() const { return this->fileFilter.rules(); }
+    void setFilterRules( const FileFilterRules &rules );
+    QString searchText() const { return this->searchIndex.query(); }
+    bool hasMoreItems() const;
+    bool canFetchMore( const QModelIndex &parent ) const;
 
     Qt::ItemFlags flags( const QModelIndex &index ) const {
         if ( !index.isValid())
@@ -74,33 +192,84 @@ public:
     }
 
 public slots:
-    void clearCache() { this->cache.clear(); }
-    void waitForThreads();
-    void stop() { this->m_stopping = true; }
-    void reset() { this->m_stopping = false; }
-
-signals:
-#ifdef ALT_PROXY_MODE
-    void iconFound( const QString &fileName, const QIcon &icon ) const;
-#else
-    void iconFound( const QString &fileName, const QIcon &icon, const QPersistentModelIndex &index ) const;
-#endif
+    void clearCache();
+    void invalidateIcons();
+    void invalidateSymlinkIcons();
+    void cancel();
+    void setVisibleRange( int first, int last );
+    void resort();
+    void setMaxItems( int count );
+    void showMoreItems() { this->setMaxItems( this->maxItems() + ProxyModelNamespace::MoreItems ); }
+    void setSearchText( const QString &text );
 
 private slots:
-#ifdef ALT_PROXY_MODE
-    void updateModel(const QString &fileName, const QIcon &icon );
-#else
-    void updateModel( const QString &fileName, const QIcon &icon, const QPersistentModelIndex &index );
-#endif
+    void scheduleBatch() { if ( !this->batchTimer.isActive()) this->batchTimer.start(); }
+    void processBatch();
+    void dispatch();
+    void sourceRowsInserted( const QModelIndex &parent, int first, int last );
+    void sourceRowsRemoved( const QModelIndex &parent, int first, int last );
+    void invalidateRows() { this->m_rowsDirty = true; }
+    void sourceRowsAboutToBeRemoved( const QModelIndex &parent, int first, int last );
+    void sourceDataChanged( const QModelIndex &topLeft, const QModelIndex &bottomRight );
+    void clearSortKeys() { this->sortKeys.clear(); }
+    void updateLimit() { this->m_limitDirty = false; this->invalidateFilter(); }
+    void searchRowsInserted( const QModelIndex &parent, int first, int last );
+    void resetSearchIndex() { if ( !this->searchIndex.query().isEmpty()) this->rebuildSearchIndex(); }
 
 protected:
     bool lessThan( const QModelIndex &left, const QModelIndex &right ) const;
+    bool filterAcceptsRow( int sourceRow, const QModelIndex &sourceParent ) const;
 
 private:
-    QHash<QString, QIcon> cache;
-    mutable QStringList queue;
+    bool isCancelled( int generation ) const { return this->guard->generation.load() != generation; }
+    QIcon setSharedIcon( const QString &fileName, const QString &key, qint64 modified, bool symLink = false ) const;
+    void releaseSharedIcon( const QString &key ) const;
+    void releaseSharedIcons();
+    QVariant placeholder( const QModelIndex &index, int role ) const;
+    void invalidateFile( const QString &fileName );
+    void forget( const QString &fileName );
+    void emitIconsChanged( QModelIndexList changed );
+    int priority( int row ) const;
+    bool isWithinMargin( int row ) const;
+    bool isSourceRoot( const QModelIndex &sourceParent ) const;
+    bool isLimited( const QModelIndex &sourceParent ) const;
+    void rebuildOrder();
+    void pushResult( const ProxyIcon &icon );
+    QList<ProxyIcon> takeResults();
+    void setState( ProxyRequest &request, ProxyRequest::States state ) const;
+    QModelIndex sourceRootIndex() const;
+    void rebuildRows( const QModelIndex &sourceRoot );
+    ProxySortKey sortKey( const QModelIndex &index ) const;
+    void updateSortKeyOptions();
+    void rebuildSearchIndex();
+    mutable QHash<QString, ProxyCacheEntry> cache;
+    mutable QHash<QString, int> sharedKeys;
+    mutable QHash<QString, QString> pendingKeys;
+    mutable QHash<QString, QHash<QString, FileMeta> > waiting;
+    mutable QHash<QString, ProxyRequest> requests;
+    mutable int m_stateCounts[ProxyRequest::StateCount];
+    mutable quint64 m_nextHandle;
+    mutable QStringList order;
+    mutable bool m_orderDirty;
+    mutable QTimer dispatchTimer;
+    int m_firstVisible;
+    int m_lastVisible;
+    int m_direction;
+    QSharedPointer<ProxyTaskGuard> guard;
+    QHash<QString, int> rows;
+    QStringList paths;
+    QString m_rowsRoot;
+    bool m_rowsDirty;
+    mutable QHash<quintptr, ProxySortKey> sortKeys;
+    QCollator collator;
+    bool m_keyCaseSensitive;
+    bool m_keyNumeric;
+    int m_maxItems;
+    FileFilter fileFilter;
+    SearchIndex searchIndex;
+    QPersistentModelIndex searchRoot;
+    bool m_limitDirty;
     FolderView *view;
-    mutable QMutex m_mutex;
-    bool m_stopping;
-    QThreadPool *threadPool;
+    QAtomicPointer<ProxyIconNode> results;
+    QTimer batchTimer;
 };
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+//
+// includes
+//
+#include "searchindex.h"
+
+/**
+ * @brief SearchIndex::clear
+ */
+void SearchIndex::clear() {
+    this->names.clear();
+    this->ids.clear();
+    this->alive.clear();
+    this->slotForId.clear();
+    this->postings.clear();
+    this->matched.clear();
+    this->m_query.clear();
+    this->m_live = 0;
+    this->m_stale = 0;
+}
+
+/**
+ * @brief SearchIndex::grams returns distinct trigrams of a (folded) name
+ * @param name
+ * @return
+ */
+QVector<quint64> SearchIndex::grams( const QString &name ) {
+    QVector<quint64> list;
+    int y;
+
+    for ( y = 0; y + SearchIndexNamespace::GramLength <= name.length(); y++ ) {
+        const quint64 gram = ( static_cast<quint64>( name.at( y ).unicode()) << 32 ) | ( static_cast<quint64>( name.at( y + 1 ).unicode()) << 16 ) | name.at( y + 2 ).unicode();
+
+        if ( !list.contains( gram ))
+            list << gram;
+    }
+
+    return list;
+}
+
+/**
+ * @brief SearchIndex::insert adds (or renames) an entry
+ * @param id
+ * @param name
+ */
+void SearchIndex::insert( quintptr id, const QString &name ) {
+    const QString folded( name.toCaseFolded());
+    int slot;
+
+    if ( this->slotForId.contains( id )) {
+        if ( !QString::compare( this->names.at( this->slotForId[id] ), folded ))
+            return;
+
+        this->remove( id );
+    }
+
+    slot = this->names.count();
+    this->names << folded;
+    this->ids << id;
+    this->alive << true;
+    this->slotForId[id] = slot;
+    this->m_live++;
+
+    foreach ( quint64 gram, SearchIndex::grams( folded ))
+        this->postings[gram] << slot;
+
+    if ( !this->m_query.isEmpty() && this->isMatch( slot ))
+        this->matched << id;
+}
+
+/**
+ * @brief SearchIndex::remove
+ * @param id
+ */
+void SearchIndex::remove( quintptr id ) {
+    const QHash<quintptr, int>::iterator slot( this->slotForId.find( id ));
+
+    if ( slot == this->slotForId.end())
+        return;
+
+    this->alive[slot.value()] = false;
+    this->names[slot.value()].clear();
+    this->slotForId.erase( slot );
+    this->matched.remove( id );
+    this->m_live--;
+    this->m_stale++;
+
+    if ( this->m_stale > SearchIndexNamespace::MinimumCompaction && this->m_stale > this->m_live )
+        this->compact();
+}
+
+/**
+ * @brief SearchIndex::compact rebuilds postings from live entries
+ */
+void SearchIndex::compact() {
+    const QVector<QString> names( this->names );
+    const QVector<quintptr> ids( this->ids );
+    const QVector<bool> alive( this->alive );
+    const QSet<quintptr> matched( this->matched );
+    const QString query( this->m_query );
+    int y;
+
+    this->clear();
+    for ( y = 0; y < names.count(); y++ ) {
+        if ( !alive.at( y ))
+            continue;
+
+        this->insert( ids.at( y ), names.at( y ));
+    }
+
+    // matches did not change
+    this->m_query = query;
+    this->matched = matched;
+}
+
+/**
+ * @brief SearchIndex::setQuery finds entries containing the text (case insensitive), narrows the
+ * previous matches if the query extends the previous one, otherwise intersects via the rarest trigram
+ * @param text
+ */
+void SearchIndex::setQuery( const QString &text ) {
+    const QString query( text.toCaseFolded());
+    QVector<int> candidates;
+    int y;
+
+    if ( !QString::compare( query, this->m_query ))
+        return;
+
+    // narrowing (typing ahead) only has to check previous matches
+    if ( !this->m_query.isEmpty() && query.contains( this->m_query )) {
+        const QSet<quintptr> previous( this->matched );
+
+        this->m_query = query;
+        this->matched.clear();
+        foreach ( quintptr id, previous ) {
+            if ( this->isMatch( this->slotForId.value( id )))
+                this->matched << id;
+        }
+        return;
+    }
+
+    this->m_query = query;
+    this->matched.clear();
+    if ( query.isEmpty())
+        return;
+
+    // short queries have no trigram, check all entries
+    if ( query.length() < SearchIndexNamespace::GramLength ) {
+        for ( y = 0; y < this->names.count(); y++ ) {
+            if ( this->isMatch( y ))
+                this->matched << this->ids.at( y );
+        }
+        return;
+    }
+
+    // every match contains all trigrams of the query, verify candidates of the rarest one
+    foreach ( quint64 gram, SearchIndex::grams( query )) {
+        const QHash<quint64, QVector<int> >::const_iterator posting( this->postings.constFind( gram ));
+
+        if ( posting == this->postings.constEnd())
+            return;
+
+        if ( candidates.isEmpty() || posting->count() < candidates.count())
+            candidates = posting.value();
+    }
+
+    foreach ( int slot, candidates ) {
+        if ( this->isMatch( slot ))
+            this->matched << this->ids.at( slot );
+    }
+}
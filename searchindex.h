@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 Zvaigznu Planetarijs
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see http://www.gnu.org/licenses/.
+ *
+ */
+
+#pragma once
+
+//
+// includes
+//
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+/**
+ * @brief The SearchIndexNamespace namespace
+ */
+namespace SearchIndexNamespace {
+static const int GramLength = 3;
+static const int MinimumCompaction = 1024;
+}
+
+/**
+ * @brief The SearchIndex class trigram index over display names of a single directory
+ *
+ * NOTE: entries are identified by a stable source model id (not by row, rows shift), removed
+ *       entries leave stale postings that are dropped during verification and compacted once
+ *       they outnumber live entries; the current query's matches are kept up to date on
+ *       insertion and removal
+ */
+class SearchIndex {
+public:
+    SearchIndex() : m_live( 0 ), m_stale( 0 ) {}
+    int count() const { return this->m_live; }
+    QString query() const { return this->m_query; }
+    void clear();
+    void insert( quintptr id, const QString &name );
+    void remove( quintptr id );
+    void setQuery( const QString &text );
+    bool matches( quintptr id ) const { return this->m_query.isEmpty() || this->matched.contains( id ); }
+    int matchCount() const { return this->matched.count(); }
+    QSet<quintptr> matchedIds() const { return this->matched; }
+
+private:
+    static QVector<quint64> grams( const QString &name );
+    bool isMatch( int slot ) const { return this->alive.at( slot ) && this->names.at( slot ).contains( this->m_query ); }
+    void compact();
+    QVector<QString> names;
+    QVector<quintptr> ids;
+    QVector<bool> alive;
+    QHash<quintptr, int> slotForId;
+    QHash<quint64, QVector<int> > postings;
+    QSet<quintptr> matched;
+    QString m_query;
+    int m_live;
+    int m_stale;
+};
@@ -52,6 +52,9 @@ TrayIcon::TrayIcon( QObject *parent ) : QSystemTrayIcon( parent ) {
     // show widget list action
     this->actionMap[Widgets] = this->contextMenu()->addAction( IconCache::instance()->icon( "view-list-icons", ":/icons/widgets", 16 ), this->tr( "Widget list" ), parentWidget, SLOT( show()));
 
+    // show quick launcher action
+    this->actionMap[QuickLaunch] = this->contextMenu()->addAction( IconCache::instance()->icon( "system-search", ":/icons/find", 16 ), this->tr( "Quick launcher" ), parentWidget, SLOT( showLauncher()));
+
     // show settings dialog action
     this->actionMap[Settings] = this->contextMenu()->addAction( IconCache::instance()->icon( "configure", ":/icons/settings", 16 ), this->tr( "Settings" ));
     this->connect( this->actionMap[Settings], SIGNAL( triggered( bool )), parentWidget, SLOT( showSettingsDialog()));
@@ -142,9 +145,12 @@ void TrayIcon::iconActivated( QSystemTrayIcon::ActivationReason reason ) {
         this->contextMenu()->exec( QCursor::pos());
         break;
 
+    case MiddleClick:
+        parentWidget->showLauncher();
+        break;
+
     case Unknown:
     case DoubleClick:
-    case MiddleClick:
         break;
     }
 }
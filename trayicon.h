@@ -36,7 +36,8 @@ public:
         Settings,
         About,
         Themes,
-        Lock
+        Lock,
+        QuickLaunch
     };
 
     explicit TrayIcon( QObject *parent = nullptr );
@@ -41,7 +41,8 @@
 WidgetList::WidgetList( QWidget *parent ) : QMainWindow( parent ), ui( new Ui::WidgetList ), model( new WidgetModel( this, this )),
     settingsDialog( new Settings( this )),
     themeDialog( new ThemeEditor( this )),
-    aboutDialog( new About( this )) {
+    aboutDialog( new About( this )),
+    launcherDialog( new Launcher( this )) {
 
     // init ui
     this->ui->setupUi( this );
@@ -100,6 +101,7 @@ WidgetList::~WidgetList() {
     delete this->settingsDialog;
     delete this->aboutDialog;
     delete this->themeDialog;
+    delete this->launcherDialog;
 
     // delete model and the ui
     delete this->model;
@@ -22,6 +22,7 @@
 // includes
 //
 #include "about.h"
+#include "launcher.h"
 #include "settings.h"
 #include "themeeditor.h"
 #include <QMainWindow>
@@ -58,6 +59,7 @@ public slots:
     void showSettingsDialog() { this->settingsDialog->exec(); }
     void showThemeDialog() { this->themeDialog->exec(); }
     void showAboutDialog() { this->aboutDialog->exec(); }
+    void showLauncher() { this->launcherDialog->show(); this->launcherDialog->raise(); this->launcherDialog->activateWindow(); }
 
 private slots:
     void on_widgetList_doubleClicked( const QModelIndex &index );
@@ -74,4 +76,5 @@ private:
     Settings *settingsDialog;
     ThemeEditor *themeDialog;
     About *aboutDialog;
+    Launcher *launcherDialog;
 };
@@ -170,6 +170,9 @@ void XMLTools::write( Modes mode, bool force ) {
             // dirsFirst
             stream.writeTextElement( "dirsFirst", QString::number( static_cast<int>( folderView->directoriesFirst())));
 
+            // numericSort
+            stream.writeTextElement( "numericSort", QString::number( static_cast<int>( folderView->isNumericSort())));
+
             // access mode
             if ( !folderView->isReadOnly())
                 stream.writeTextElement( "readOnly", QString::number( 0 ));
@@ -177,6 +180,28 @@ void XMLTools::write( Modes mode, bool force ) {
             // icon size
             stream.writeTextElement( "iconSize", QString::number( folderView->iconSize()));
 
+            // item limit
+            if ( folderView->maxItems() > 0 )
+                stream.writeTextElement( "maxItems", QString::number( folderView->maxItems()));
+
+            // filter rules
+            if ( !folderView->filterRules().isDefault()) {
+                const FileFilterRules rules( folderView->filterRules());
+
+                stream.writeStartElement( "filter" );
+                stream.writeAttribute( "hidden", QString::number( static_cast<int>( rules.hidden )));
+                stream.writeAttribute( "maximumSize", QString::number( rules.maximumSize ));
+                stream.writeAttribute( "maximumAge", QString::number( rules.maximumAge ));
+
+                foreach ( const QString &pattern, rules.includes )
+                    stream.writeTextElement( "include", pattern );
+
+                foreach ( const QString &pattern, rules.excludes )
+                    stream.writeTextElement( "exclude", pattern );
+
+                stream.writeEndElement();
+            }
+
             // end widget element
             stream.writeEndElement();
         }
@@ -368,6 +393,7 @@ void XMLTools::read( Modes mode ) {
                 Qt::SortOrder sortOrder = Qt::AscendingOrder;
                 bool dirsFirst = true;
                 bool caseSensitive = false;
+                bool numericSort = false;
 
                 childNode = element.firstChild();
                 widget = new FolderView( nullptr, element.attribute( "rootPath" ));
@@ -400,8 +426,30 @@ void XMLTools::read( Modes mode ) {
                             dirsFirst = static_cast<bool>( text.toInt());
                         } else if ( !QString::compare( childElement.tagName(), "caseSensitive" )) {
                             caseSensitive = static_cast<bool>( text.toInt());
+                        } else if ( !QString::compare( childElement.tagName(), "numericSort" )) {
+                            numericSort = static_cast<bool>( text.toInt());
                         } else if ( !QString::compare( childElement.tagName(), "iconSize" )) {
                             widget->setIconSize( text.toInt());
+                        } else if ( !QString::compare( childElement.tagName(), "maxItems" )) {
+                            widget->setMaxItems( text.toInt());
+                        } else if ( !QString::compare( childElement.tagName(), "filter" )) {
+                            FileFilterRules rules;
+                            QDomElement patternElement( childElement.firstChildElement());
+
+                            rules.hidden = static_cast<bool>( childElement.attribute( "hidden" ).toInt());
+                            rules.maximumSize = childElement.attribute( "maximumSize" ).toLongLong();
+                            rules.maximumAge = childElement.attribute( "maximumAge" ).toInt();
+
+                            while ( !patternElement.isNull()) {
+                                if ( !QString::compare( patternElement.tagName(), "include" ))
+                                    rules.includes << patternElement.text();
+                                else if ( !QString::compare( patternElement.tagName(), "exclude" ))
+                                    rules.excludes << patternElement.text();
+
+                                patternElement = patternElement.nextSiblingElement();
+                            }
+
+                            widget->setFilterRules( rules );
                         }
                     }
 
@@ -419,6 +467,7 @@ void XMLTools::read( Modes mode ) {
 
                 widget->setGeometry( widgetGeometry );
                 widget->setCaseSensitive( caseSensitive );
+                widget->setNumericSort( numericSort );
                 widget->setDirectoriesFirst( dirsFirst );
                 widget->setReadOnly( readOnly );
                 widget->setSortOrder( sortOrder );